@@ -0,0 +1,332 @@
+#pragma once
+
+#include "loglevel.h"
+#include "filewriter.h"
+#include "logformat.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Двоичный журнал: вместо готового текста на диск пишутся уровень, время, номер потока,
+// номер шаблона и типизированные аргументы. Текст собирается потом, утилитой logdecode.
+//
+// Формат файла (числа — в порядке байт машины, на которой писали):
+//   "LOGB" u16 версия
+//   'F' u32 id u32 длина байты                     — определение шаблона, до первого использования
+//   'R' u8 уровень u64 нс_эпохи u32 поток u32 id u8 число_аргументов аргументы...
+// Аргумент: 'i' i64 | 'u' u64 | 'f' float | 'd' double | 'b' u8 | 'c' char | 's' u32 длина байты
+// Версия 2 добавила 'f'; файлы версии 1 читаются как прежде
+namespace binlog
+{
+    constexpr char kMagic[4] = { 'L', 'O', 'G', 'B' };
+    constexpr std::uint16_t kVersion = 2;
+
+    // Шаблон сообщения с номером, выданным один раз на всё время работы программы
+    struct FormatSite
+    {
+        std::string_view text;
+        std::uint32_t id;
+    };
+
+    inline std::uint32_t next_format_id()
+    {
+        static std::atomic<std::uint32_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Небольшой номер потока вместо std::thread::id, который занимает 8 байт и нечитаем
+    inline std::uint32_t thread_number()
+    {
+        static std::atomic<std::uint32_t> counter{0};
+        thread_local std::uint32_t number = counter.fetch_add(1, std::memory_order_relaxed);
+        return number;
+    }
+
+    template <typename T>
+    void put(std::string& out, T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.append(bytes, sizeof(T));
+    }
+
+    inline void put_string(std::string& out, std::string_view value)
+    {
+        out.push_back('s');
+        put(out, static_cast<std::uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    inline void put_arg(std::string& out, std::string_view value) { put_string(out, value); }
+    inline void put_arg(std::string& out, const std::string& value) { put_string(out, value); }
+    inline void put_arg(std::string& out, const char* value) { put_string(out, value ? value : "(null)"); }
+    inline void put_arg(std::string& out, char value) { out.push_back('c'); out.push_back(value); }
+    inline void put_arg(std::string& out, bool value) { out.push_back('b'); out.push_back(value ? 1 : 0); }
+
+    template <typename T>
+    std::enable_if_t<std::is_arithmetic_v<T>> put_arg(std::string& out, T value)
+    {
+        if constexpr (std::is_same_v<T, float>)
+        {
+            // float остаётся float: to_chars(float) даёт "0.1", а расширенный до double — "0.10000000149011612"
+            out.push_back('f');
+            put(out, value);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            out.push_back('d');
+            put(out, static_cast<double>(value));
+        }
+        else if constexpr (std::is_signed_v<T>)
+        {
+            out.push_back('i');
+            put(out, static_cast<std::int64_t>(value));
+        }
+        else
+        {
+            out.push_back('u');
+            put(out, static_cast<std::uint64_t>(value));
+        }
+    }
+}
+
+// Шаблон со статическим номером: BinaryLogger::log(LogLevel::INFO, LOG_FORMAT("disk {} full"), name)
+#define LOG_FORMAT(text)                                                                \
+    ([]() -> const binlog::FormatSite&                                                  \
+    {                                                                                   \
+        static const binlog::FormatSite site{ text, binlog::next_format_id() };         \
+        return site;                                                                    \
+    }())
+
+// Пишет структурированные записи в двоичный файл. Форматирования в горячем пути нет:
+// аргументы копируются как есть, шаблон пишется в файл один раз
+class BinaryLogger
+{
+    private:
+
+        bool new_file_;  // заголовок пишется только в новый файл, дальше журнал дописывается
+        BufferedFileWriter writer_;
+        std::mutex mutex_;
+        std::vector<bool> defined_;  // какие шаблоны уже записаны в этот файл
+        std::atomic<LevelMask> enabled_mask_{levels_from(kCompiledMinLevel)};
+
+        static bool needs_header(const std::string& path)
+        {
+            std::error_code error;
+            return !std::filesystem::exists(path, error) || std::filesystem::file_size(path, error) == 0;
+        }
+
+        void define(const binlog::FormatSite& site, std::string& out)
+        {
+            if (site.id < defined_.size() && defined_[site.id]) return;
+            if (site.id >= defined_.size()) defined_.resize(site.id + 1, false);
+            defined_[site.id] = true;
+
+            out.push_back('F');
+            binlog::put(out, site.id);
+            binlog::put(out, static_cast<std::uint32_t>(site.text.size()));
+            out.append(site.text);
+        }
+
+    public:
+
+        explicit BinaryLogger(const std::string& file_path, FileBufferOptions options = {})
+            : new_file_(needs_header(file_path))
+            , writer_(file_path, options)
+        {
+            if (new_file_)
+            {
+                std::string header(binlog::kMagic, sizeof(binlog::kMagic));
+                binlog::put(header, binlog::kVersion);
+                writer_.write_bytes(LogLevel::TRACE, header);
+            }
+        }
+
+        bool is_enabled(LogLevel level) const
+        {
+            return level >= kCompiledMinLevel
+                && (enabled_mask_.load(std::memory_order_relaxed) & level_bit(level)) != 0;
+        }
+
+        void set_level(LogLevel level) { enabled_mask_.store(levels_from(level), std::memory_order_relaxed); }
+
+        template <typename... Args>
+        void log(LogLevel level, const binlog::FormatSite& site, const Args&... args)
+        {
+            static_assert(sizeof...(Args) < 256, "too many arguments");
+            if (!is_enabled(level)) return;
+
+            // Запись собирается в буфере потока, под замком только копирование в общий буфер
+            thread_local std::string record;
+            record.clear();
+            record.push_back('R');
+            record.push_back(static_cast<char>(level));
+            auto now = std::chrono::system_clock::now().time_since_epoch();
+            binlog::put(record, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()));
+            binlog::put(record, binlog::thread_number());
+            binlog::put(record, site.id);
+            record.push_back(static_cast<char>(sizeof...(Args)));
+            (binlog::put_arg(record, args), ...);
+
+            thread_local std::string definition;
+            definition.clear();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            define(site, definition);
+            if (!definition.empty()) writer_.write_bytes(LogLevel::TRACE, definition);
+            writer_.write_bytes(level, record);
+        }
+
+        void flush()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writer_.flush();
+        }
+};
+
+// Чтение двоичного журнала и сборка текста — для утилиты logdecode и проверок
+class BinaryLogReader
+{
+    private:
+
+        std::string data_;
+        std::size_t position_ = 0;
+        std::unordered_map<std::uint32_t, std::string> formats_;
+        std::string skipped_;  // сюда читаются лишние аргументы
+
+        template <typename T>
+        bool get(T& value)
+        {
+            if (data_.size() - position_ < sizeof(T)) return false;
+            std::memcpy(&value, data_.data() + position_, sizeof(T));
+            position_ += sizeof(T);
+            return true;
+        }
+
+        bool get_bytes(std::size_t size, std::string_view& value)
+        {
+            if (data_.size() - position_ < size) return false;
+            value = std::string_view(data_).substr(position_, size);
+            position_ += size;
+            return true;
+        }
+
+        bool append_arg(std::string& out)
+        {
+            char tag = 0;
+            if (!get(tag)) return false;
+            switch (tag)
+            {
+                case 'i': { std::int64_t v = 0; if (!get(v)) return false; logformat::append_arg(out, v); return true; }
+                case 'u': { std::uint64_t v = 0; if (!get(v)) return false; logformat::append_arg(out, v); return true; }
+                case 'f': { float v = 0; if (!get(v)) return false; logformat::append_arg(out, v); return true; }
+                case 'd': { double v = 0; if (!get(v)) return false; logformat::append_arg(out, v); return true; }
+                case 'b': { std::uint8_t v = 0; if (!get(v)) return false; logformat::append_arg(out, v != 0); return true; }
+                case 'c': { char v = 0; if (!get(v)) return false; logformat::append_arg(out, v); return true; }
+                case 's':
+                {
+                    std::uint32_t size = 0;
+                    std::string_view v;
+                    if (!get(size) || !get_bytes(size, v)) return false;
+                    logformat::append_arg(out, v);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    public:
+
+        struct Record
+        {
+            LogLevel level = LogLevel::INFO;
+            std::uint64_t timestamp_ns = 0;
+            std::uint32_t thread = 0;
+            std::string text;
+        };
+
+        // false — файл не открылся или это не двоичный журнал
+        bool open(const std::string& path)
+        {
+            std::error_code error;
+            auto size = std::filesystem::file_size(path, error);
+            if (error) return false;
+
+            data_.assign(size, '\0');
+            FILE* file = std::fopen(path.c_str(), "rb");
+            if (!file) return false;
+            std::size_t read = std::fread(data_.data(), 1, data_.size(), file);
+            std::fclose(file);
+            data_.resize(read);
+
+            position_ = 0;
+            std::string_view magic;
+            std::uint16_t version = 0;
+            return get_bytes(sizeof(binlog::kMagic), magic)
+                && magic == std::string_view(binlog::kMagic, sizeof(binlog::kMagic))
+                && get(version) && version >= 1 && version <= binlog::kVersion;
+        }
+
+        // Следующая запись; false — конец файла или обрезанный хвост
+        bool next(Record& record)
+        {
+            for (;;)
+            {
+                char kind = 0;
+                if (!get(kind)) return false;
+
+                if (kind == 'F')
+                {
+                    std::uint32_t id = 0;
+                    std::uint32_t size = 0;
+                    std::string_view text;
+                    if (!get(id) || !get(size) || !get_bytes(size, text)) return false;
+                    formats_[id] = std::string(text); // новый запуск программы может переопределить номер
+                    continue;
+                }
+                if (kind != 'R') return false;
+
+                std::uint8_t level = 0;
+                std::uint32_t id = 0;
+                std::uint8_t argc = 0;
+                if (!get(level) || !get(record.timestamp_ns) || !get(record.thread) || !get(id) || !get(argc))
+                    return false;
+                record.level = static_cast<LogLevel>(level);
+
+                auto format = formats_.find(id);
+                bool known = format != formats_.end();
+                std::string_view fmt = known ? std::string_view(format->second) : std::string_view("<unknown format>");
+
+                // Правило то же, что у logformat::format_to: лишние аргументы отбрасываются,
+                // и расшифрованный журнал совпадает с текстовым. Но байты аргумента всё равно
+                // читаются. Без шаблона аргументы — единственное, что есть, их пишем через пробел
+                record.text.clear();
+                bool found = false;
+                for (std::uint8_t i = 0; i < argc; ++i)
+                {
+                    if (!known)
+                    {
+                        record.text.push_back(' ');
+                        if (!append_arg(record.text)) return false;
+                        continue;
+                    }
+
+                    fmt = logformat::append_literal(record.text, fmt, found);
+                    skipped_.clear();
+                    if (!append_arg(found ? record.text : skipped_)) return false;
+                }
+                if (known) logformat::format_to(record.text, fmt);
+                else record.text.insert(0, fmt);
+                return true;
+            }
+        }
+};
\ No newline at end of file
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "ilogfilter.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Статистика одного фильтра внутри составного
+struct FilterStats
+{
+    std::uint64_t accepted = 0;
+    std::uint64_t rejected = 0;
+    double average_ns = 0.0;   // среднее время одной проверки по выборочным замерам
+};
+
+// Общая часть AndFilter и OrFilter: вычисляет детей до первого решающего ответа
+// и по ходу дела подстраивает их порядок. Первыми идут фильтры с наименьшим отношением
+// "цена / вероятность сразу дать окончательный ответ" — для И это вероятность отказа,
+// для ИЛИ — вероятность совпадения. Для фильтров без состояния от порядка зависит только время.
+// Фильтры с reorderable() == false стоят на своих местах, и остальные переставляются только
+// между ними: до такого фильтра доходят те же записи, что и без перестановок
+class CompositeFilter : public ILogFilter
+{
+    private:
+
+        static constexpr std::size_t kMaxReordered = 16;      // порядок упакован в 64 бита по 4 бита
+        static constexpr std::uint64_t kTimeEvery = 16;       // каждая 16-я проверка замеряется
+        static constexpr std::uint64_t kReorderEvery = 4096;  // пересчёт порядка
+
+        // Счётчики каждого ребёнка в своей кэш-линии, чтобы потоки не мешали друг другу
+        struct alignas(64) Counters
+        {
+            std::atomic<std::uint64_t> accepted{0};
+            std::atomic<std::uint64_t> rejected{0};
+            std::atomic<std::uint64_t> timed{0};
+            std::atomic<std::uint64_t> time_ns{0};
+        };
+
+        std::vector<std::unique_ptr<ILogFilter>> children_;
+        std::unique_ptr<Counters[]> counters_;
+        bool decisive_;          // ответ ребёнка, после которого остальных можно не проверять
+        bool uses_text_ = false;
+        bool reorderable_ = true;
+
+        mutable std::atomic<std::uint64_t> evaluations_{0};
+        mutable std::atomic<std::uint64_t> order_{0};  // i-я тетрада — номер ребёнка на i-м месте
+
+        std::size_t child_at(std::uint64_t order, std::size_t position) const
+        {
+            if (children_.size() > kMaxReordered) return position;
+            return static_cast<std::size_t>((order >> (4 * position)) & 0xF);
+        }
+
+        void reorder() const
+        {
+            if (children_.size() < 2 || children_.size() > kMaxReordered) return;
+
+            std::vector<std::pair<double, std::size_t>> ranked;
+            auto sort_segment = [&](std::size_t from)
+            {
+                std::stable_sort(ranked.begin() + static_cast<std::ptrdiff_t>(from), ranked.end());
+            };
+
+            std::size_t segment = 0;  // начало текущего отрезка между закреплёнными детьми
+            for (std::size_t i = 0; i < children_.size(); ++i)
+            {
+                if (!children_[i]->reorderable())
+                {
+                    sort_segment(segment);
+                    ranked.emplace_back(0.0, i);
+                    segment = ranked.size();
+                    continue;
+                }
+
+                const Counters& c = counters_[i];
+                double accepted = static_cast<double>(c.accepted.load(std::memory_order_relaxed));
+                double rejected = static_cast<double>(c.rejected.load(std::memory_order_relaxed));
+                double timed = static_cast<double>(c.timed.load(std::memory_order_relaxed));
+                double cost = timed > 0 ? static_cast<double>(c.time_ns.load(std::memory_order_relaxed)) / timed : 1.0;
+
+                // Сглаживание Лапласа: у фильтра без статистики вероятность 1/2
+                double decisive = decisive_ ? accepted : rejected;
+                double probability = (decisive + 1.0) / (accepted + rejected + 2.0);
+                ranked.emplace_back(cost / probability, i);
+            }
+            sort_segment(segment);
+
+            std::uint64_t order = 0;
+            for (std::size_t position = 0; position < ranked.size(); ++position)
+            {
+                order |= static_cast<std::uint64_t>(ranked[position].second) << (4 * position);
+            }
+            order_.store(order, std::memory_order_relaxed);
+        }
+
+    protected:
+
+        CompositeFilter(std::vector<std::unique_ptr<ILogFilter>> children, bool decisive)
+            : children_(std::move(children))
+            , counters_(new Counters[children_.size()])
+            , decisive_(decisive)
+        {
+            std::uint64_t order = 0;
+            for (std::size_t i = 0; i < children_.size(); ++i)
+            {
+                uses_text_ = uses_text_ || children_[i]->uses_text();
+                reorderable_ = reorderable_ && children_[i]->reorderable();
+                if (i < kMaxReordered) order |= static_cast<std::uint64_t>(i) << (4 * i);
+            }
+            order_.store(order, std::memory_order_relaxed);
+        }
+
+        // Возвращает decisive_, если хоть один ребёнок ответил decisive_, иначе !decisive_
+        bool evaluate(LogLevel level, const std::string& text) const
+        {
+            std::uint64_t evaluation = evaluations_.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (evaluation % kReorderEvery == 0) reorder();
+            bool timed = evaluation % kTimeEvery == 0;
+
+            std::uint64_t order = order_.load(std::memory_order_relaxed);
+            for (std::size_t position = 0; position < children_.size(); ++position)
+            {
+                std::size_t index = child_at(order, position);
+                Counters& c = counters_[index];
+
+                bool result;
+                if (timed)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    result = children_[index]->match(level, text);
+                    auto elapsed = std::chrono::steady_clock::now() - start;
+                    c.time_ns.fetch_add(static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), std::memory_order_relaxed);
+                    c.timed.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    result = children_[index]->match(level, text);
+                }
+
+                (result ? c.accepted : c.rejected).fetch_add(1, std::memory_order_relaxed);
+                if (result == decisive_) return decisive_;
+            }
+            return !decisive_;
+        }
+
+    public:
+
+        bool uses_text() const override { return uses_text_; }
+        bool reorderable() const override { return reorderable_; }
+
+        std::size_t size() const { return children_.size(); }
+
+        // Статистика в порядке, в котором дети были переданы в конструктор
+        std::vector<FilterStats> stats() const
+        {
+            std::vector<FilterStats> result(children_.size());
+            for (std::size_t i = 0; i < children_.size(); ++i)
+            {
+                const Counters& c = counters_[i];
+                result[i].accepted = c.accepted.load(std::memory_order_relaxed);
+                result[i].rejected = c.rejected.load(std::memory_order_relaxed);
+                std::uint64_t timed = c.timed.load(std::memory_order_relaxed);
+                result[i].average_ns = timed ? static_cast<double>(c.time_ns.load(std::memory_order_relaxed)) / static_cast<double>(timed) : 0.0;
+            }
+            return result;
+        }
+
+        // Текущий порядок проверки: номера детей в порядке конструктора
+        std::vector<std::size_t> order() const
+        {
+            std::vector<std::size_t> result;
+            std::uint64_t order = order_.load(std::memory_order_relaxed);
+            for (std::size_t position = 0; position < children_.size(); ++position)
+            {
+                result.push_back(child_at(order, position));
+            }
+            return result;
+        }
+};
+
+// Все дети должны согласиться; пустой AndFilter пропускает всё
+class AndFilter : public CompositeFilter
+{
+    public:
+
+        explicit AndFilter(std::vector<std::unique_ptr<ILogFilter>> children)
+            : CompositeFilter(std::move(children), false) {}
+
+        bool match(LogLevel level, const std::string& text) const override
+        {
+            return evaluate(level, text);
+        }
+};
+
+// Достаточно одного согласного ребёнка; пустой OrFilter не пропускает ничего
+class OrFilter : public CompositeFilter
+{
+    public:
+
+        explicit OrFilter(std::vector<std::unique_ptr<ILogFilter>> children)
+            : CompositeFilter(std::move(children), true) {}
+
+        bool match(LogLevel level, const std::string& text) const override
+        {
+            return evaluate(level, text);
+        }
+};
+
+// Отрицание
+class NotFilter : public ILogFilter
+{
+    private:
+
+        std::unique_ptr<ILogFilter> child_;
+
+    public:
+
+        explicit NotFilter(std::unique_ptr<ILogFilter> child) : child_(std::move(child)) {}
+
+        bool match(LogLevel level, const std::string& text) const override
+        {
+            return !child_->match(level, text);
+        }
+
+        bool uses_text() const override { return child_->uses_text(); }
+        bool reorderable() const override { return child_->reorderable(); }
+};
\ No newline at end of file
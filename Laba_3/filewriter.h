@@ -0,0 +1,234 @@
+#pragma once
+
+#include "loglevel.h"
+#include "iloghandler.h"
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Настройки буферизации файловых обработчиков.
+// flush_interval проверяется при следующей записи: сам писатель таймера не держит. Асинхронный
+// Logger сбрасывает обработчики, как только разобрал очередь, а синхронному, у которого записи
+// бывают редко, нужен PeriodicFlusher — иначе последняя запись ждёт следующей или flush()
+struct FileBufferOptions
+{
+    std::size_t buffer_size = 64 * 1024;                 // сброс, когда буфер заполнен
+    std::chrono::milliseconds flush_interval{1000};      // сброс при записи, если с прошлого прошло больше
+    LogLevel flush_level = LogLevel::ERROR;              // записи этого уровня сбрасываются сразу
+};
+
+// Общий буферизованный писатель для всех файловых обработчиков: файл держится открытым,
+// записи копятся в буфере и уходят на диск одним системным вызовом за пачку
+class BufferedFileWriter
+{
+    private:
+
+        std::string file_path_;
+        FileBufferOptions options_;
+        int fd_ = -1;
+        bool owns_fd_ = true;          // чужой дескриптор (stdout) не закрываем и не переоткрываем
+        std::string buffer_;
+        std::chrono::steady_clock::time_point last_flush_;
+        std::uint64_t file_size_ = 0;  // размер файла вместе с ещё не сброшенным буфером
+
+#if LOGGER_METRICS
+        // Пишет только владелец писателя, читать можно из любого потока
+        std::atomic<std::uint64_t> written_bytes_{0};
+        std::atomic<std::uint64_t> writes_{0};
+        std::atomic<std::uint64_t> write_ns_{0};
+        std::atomic<std::uint64_t> write_max_ns_{0};
+
+        static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t delta)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+#endif
+
+        void open_file()
+        {
+            fd_ = ::open(file_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+            struct stat info{};
+            file_size_ = (fd_ >= 0 && fstat(fd_, &info) == 0) ? static_cast<std::uint64_t>(info.st_size) : 0;
+        }
+
+        void close_file()
+        {
+            if (fd_ >= 0 && owns_fd_)
+            {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+
+        // writev() может записать не всё или прерваться сигналом — дописываем остаток
+        void write_all(iovec* iov, int count)
+        {
+#if LOGGER_METRICS
+            auto start = std::chrono::steady_clock::now();
+            std::uint64_t total = 0;
+#endif
+            while (count > 0 && fd_ >= 0)
+            {
+                ssize_t written = ::writev(fd_, iov, count);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    break; // ошибка записи: как и раньше, молча теряем сообщение
+                }
+
+                auto left = static_cast<std::size_t>(written);
+#if LOGGER_METRICS
+                total += left;
+#endif
+                while (count > 0 && left >= iov->iov_len)
+                {
+                    left -= iov->iov_len;
+                    ++iov;
+                    --count;
+                }
+                if (count > 0)
+                {
+                    iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                    iov->iov_len -= left;
+                }
+            }
+#if LOGGER_METRICS
+            auto elapsed = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            bump(written_bytes_, total);
+            bump(writes_, 1);
+            bump(write_ns_, elapsed);
+            if (elapsed > write_max_ns_.load(std::memory_order_relaxed))
+                write_max_ns_.store(elapsed, std::memory_order_relaxed);
+#endif
+        }
+
+        void write_parts(LogLevel level, std::string_view prefix, std::string_view text, std::string_view suffix)
+        {
+            if (fd_ < 0) return;
+
+            std::size_t size = prefix.size() + text.size() + suffix.size();
+            file_size_ += size;
+            if (buffer_.size() + size > options_.buffer_size)
+            {
+                iovec iov[4] = {
+                    { buffer_.data(), buffer_.size() },
+                    { const_cast<char*>(prefix.data()), prefix.size() },
+                    { const_cast<char*>(text.data()), text.size() },
+                    { const_cast<char*>(suffix.data()), suffix.size() },
+                };
+                write_all(iov, 4);
+                buffer_.clear();
+                last_flush_ = std::chrono::steady_clock::now();
+                return;
+            }
+
+            buffer_.append(prefix);
+            buffer_.append(text);
+            buffer_.append(suffix);
+
+            if (buffer_.size() >= options_.buffer_size
+                || level >= options_.flush_level
+                || std::chrono::steady_clock::now() - last_flush_ >= options_.flush_interval)
+            {
+                flush();
+            }
+        }
+
+    public:
+
+        explicit BufferedFileWriter(const std::string& file_path, FileBufferOptions options = {})
+            : file_path_(file_path)
+            , options_(options)
+            , last_flush_(std::chrono::steady_clock::now())
+        {
+            buffer_.reserve(options_.buffer_size);
+            open_file();
+        }
+
+        // Пишет в уже открытый дескриптор, например 1 для stdout; name нужен только для path()
+        BufferedFileWriter(int fd, const std::string& name, FileBufferOptions options = {})
+            : file_path_(name)
+            , options_(options)
+            , fd_(fd)
+            , owns_fd_(false)
+            , last_flush_(std::chrono::steady_clock::now())
+        {
+            buffer_.reserve(options_.buffer_size);
+        }
+
+        BufferedFileWriter(const BufferedFileWriter&) = delete;
+        BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+        ~BufferedFileWriter()
+        {
+            flush();
+            close_file();
+        }
+
+        // Добавляет строку "prefix + text\n". Если запись не помещается в буфер,
+        // буфер и запись уходят одним writev() без лишнего копирования
+        void write(LogLevel level, std::string_view prefix, std::string_view text)
+        {
+            write_parts(level, prefix, text, "\n");
+        }
+
+        // То же, но перевод строки (если нужен) передаёт сам вызывающий в suffix
+        void write(LogLevel level, std::string_view prefix, std::string_view text, std::string_view suffix)
+        {
+            write_parts(level, prefix, text, suffix);
+        }
+
+        // Добавляет байты как есть — для двоичных журналов
+        void write_bytes(LogLevel level, std::string_view data)
+        {
+            write_parts(level, {}, data, {});
+        }
+
+        void flush()
+        {
+            if (!buffer_.empty())
+            {
+                iovec iov{ buffer_.data(), buffer_.size() };
+                write_all(&iov, 1);
+                buffer_.clear();
+            }
+            last_flush_ = std::chrono::steady_clock::now();
+        }
+
+        // Переоткрыть файл по тому же пути — после того как его переименовала внешняя ротация
+        void reopen()
+        {
+            flush();
+            if (!owns_fd_) return;
+            close_file();
+            open_file();
+        }
+
+        const std::string& path() const { return file_path_; }
+        std::uint64_t size() const { return file_size_; }
+
+        // Счётчики записей на устройство; false, если собрано с LOGGER_METRICS=0
+        bool io_stats(HandlerIoStats& stats) const
+        {
+#if LOGGER_METRICS
+            stats.bytes = written_bytes_.load(std::memory_order_relaxed);
+            stats.flushes = writes_.load(std::memory_order_relaxed);
+            stats.flush_ns = write_ns_.load(std::memory_order_relaxed);
+            stats.flush_max_ns = write_max_ns_.load(std::memory_order_relaxed);
+            return true;
+#else
+            (void)stats;
+            return false;
+#endif
+        }
+};
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ilogformatter.h"
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Цепочка форматтеров: каждый следующий получает результат предыдущего.
+// Идущие подряд IAffixFormatter сливаются в одну ступень: для f1, f2, ..., fn результат —
+// pn ... p2 p1 text s1 s2 ... sn, и он собирается за один проход без промежуточных строк.
+// Остальные форматтеры остаются отдельными ступенями и работают через format_to()
+class FormatterChain
+{
+    private:
+
+        struct Stage
+        {
+            std::vector<const IAffixFormatter*> affixes; // пусто — ступень из одного обычного форматтера
+            const ILogFormatter* plain = nullptr;
+        };
+
+        std::vector<std::unique_ptr<ILogFormatter>> formatters_;
+        std::vector<Stage> stages_;
+
+        // timestamp_ns == kNoTimestamp — форматтеры сами берут текущее время
+        static void apply(const Stage& stage, LogLevel level, std::int64_t timestamp_ns, const std::string& text,
+                          std::string& out)
+        {
+            if (stage.plain)
+            {
+                if (timestamp_ns == kNoTimestamp) stage.plain->format_to(level, text, out);
+                else stage.plain->format_at(level, timestamp_ns, text, out);
+                return;
+            }
+
+            out.clear();
+            for (auto it = stage.affixes.rbegin(); it != stage.affixes.rend(); ++it)
+            {
+                if (timestamp_ns == kNoTimestamp) (*it)->append_prefix(level, out);
+                else (*it)->append_prefix_at(level, timestamp_ns, out);
+            }
+            out.append(text);
+            for (const IAffixFormatter* affix : stage.affixes)
+            {
+                affix->append_suffix(level, out);
+            }
+        }
+
+    public:
+
+        static constexpr std::int64_t kNoTimestamp = std::numeric_limits<std::int64_t>::min();
+
+        FormatterChain() = default;
+
+        explicit FormatterChain(std::vector<std::unique_ptr<ILogFormatter>> formatters)
+            : formatters_(std::move(formatters))
+        {
+            for (const auto& formatter : formatters_)
+            {
+                if (auto* affix = dynamic_cast<const IAffixFormatter*>(formatter.get()))
+                {
+                    if (stages_.empty() || stages_.back().plain) stages_.emplace_back();
+                    stages_.back().affixes.push_back(affix);
+                }
+                else
+                {
+                    stages_.push_back(Stage{{}, formatter.get()});
+                }
+            }
+        }
+
+        // Прогоняет text через цепочку. front и back — рабочие буферы вызывающего;
+        // возвращается ссылка на тот, где лежит результат (или на сам text, если цепочка пуста)
+        const std::string& run(LogLevel level, const std::string& text, std::string& front, std::string& back) const
+        {
+            return run(level, kNoTimestamp, text, front, back);
+        }
+
+        // То же, но время записи задано: так его видят все форматтеры цепочки
+        const std::string& run(LogLevel level, std::int64_t timestamp_ns, const std::string& text,
+                               std::string& front, std::string& back) const
+        {
+            const std::string* input = &text;
+            for (const Stage& stage : stages_)
+            {
+                apply(stage, level, timestamp_ns, *input, front);
+                front.swap(back);
+                input = &back;
+            }
+            return *input;
+        }
+
+        bool empty() const { return stages_.empty(); }
+        std::size_t stage_count() const { return stages_.size(); }
+};
\ No newline at end of file
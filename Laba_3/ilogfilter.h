@@ -9,5 +9,14 @@ class ILogFilter
     
         virtual bool match(LogLevel level, const std::string& text) const = 0;
 
+        // false — фильтр смотрит только на уровень. Такие фильтры Logger проверяет раньше
+        // остальных, ещё до того, как отложенное сообщение будет построено
+        virtual bool uses_text() const { return true; }
+
+        // false — у фильтра есть состояние, которое меняют только дошедшие до него записи
+        // (токены, счётчики). Такой фильтр остаётся на своём месте: переставлять соседей через него
+        // нельзя, иначе до него дойдут другие записи и изменится результат
+        virtual bool reorderable() const { return true; }
+
         virtual ~ILogFilter() = default;
 };
\ No newline at end of file
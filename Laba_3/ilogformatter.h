@@ -1,6 +1,7 @@
 #pragma once 
 
 #include "loglevel.h"
+#include <cstdint>
 #include <string>
   
 class ILogFormatter 
@@ -9,5 +10,61 @@ class ILogFormatter
 
         virtual std::string format(LogLevel level, const std::string& text) const = 0;
 
+        // Пишет результат в переданный буфер, чтобы его можно было переиспользовать между
+        // вызовами. По умолчанию сводится к format(); быстрые форматтеры переопределяют
+        virtual void format_to(LogLevel level, const std::string& text, std::string& out) const
+        {
+            out = format(level, text);
+        }
+
+        // То же для записи, время которой уже известно (наносекунды с эпохи): асинхронный
+        // Logger засекает его в log(), а форматирует позже. Форматтеры без времени его не замечают
+        virtual void format_at(LogLevel level, std::int64_t /*timestamp_ns*/, const std::string& text,
+                               std::string& out) const
+        {
+            format_to(level, text, out);
+        }
+
         virtual ~ILogFormatter() = default;
+};
+
+// Форматтер, который только обрамляет текст: дописывает что-то до него и после.
+// Несколько таких подряд FormatterChain сливает в один проход по одному буферу.
+// format() и format_to() — переходник к старому интерфейсу, переопределять их не нужно
+class IAffixFormatter : public ILogFormatter
+{
+    public:
+
+        virtual void append_prefix(LogLevel level, std::string& out) const = 0;
+        virtual void append_suffix(LogLevel /*level*/, std::string& /*out*/) const {}
+
+        // Префикс для записи с уже известным временем; форматтеры со временем переопределяют
+        virtual void append_prefix_at(LogLevel level, std::int64_t /*timestamp_ns*/, std::string& out) const
+        {
+            append_prefix(level, out);
+        }
+
+        std::string format(LogLevel level, const std::string& text) const override
+        {
+            std::string result;
+            format_to(level, text, result);
+            return result;
+        }
+
+        void format_to(LogLevel level, const std::string& text, std::string& out) const override
+        {
+            out.clear();
+            append_prefix(level, out);
+            out.append(text);
+            append_suffix(level, out);
+        }
+
+        void format_at(LogLevel level, std::int64_t timestamp_ns, const std::string& text,
+                       std::string& out) const override
+        {
+            out.clear();
+            append_prefix_at(level, timestamp_ns, out);
+            out.append(text);
+            append_suffix(level, out);
+        }
 };
\ No newline at end of file
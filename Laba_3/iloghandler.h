@@ -1,7 +1,23 @@
 #pragma once 
 
 #include "loglevel.h"
+#include <cstdint>
 #include <string>
+
+// LOGGER_METRICS=0 убирает счётчики Logger и писателей (цель LogBenchNoMetrics)
+#ifndef LOGGER_METRICS
+#define LOGGER_METRICS 1
+#endif
+
+// Что обработчик на самом деле отдал устройству: байты вместе с префиксами и переводами строк
+// и каждую запись буфера — по заполнению, по уровню, по интервалу и по flush()
+struct HandlerIoStats
+{
+    std::uint64_t bytes = 0;
+    std::uint64_t flushes = 0;
+    std::uint64_t flush_ns = 0;
+    std::uint64_t flush_max_ns = 0;
+};
  
 class ILogHandler 
 {
@@ -9,5 +25,13 @@ class ILogHandler
 
         virtual void handle(LogLevel level, const std::string& text) = 0;
 
+        // Сбросить накопленные записи на устройство; небуферизованным обработчикам делать нечего
+        virtual void flush() {}
+
+        // true — обработчик сам считает, что и как записал, и stats заполнен. Иначе Logger
+        // считает байты по длине строк, а время — только своих вызовов flush().
+        // Зовётся из другого потока без замка обработчика: счётчики должны быть атомарными
+        virtual bool io_stats(HandlerIoStats& /*stats*/) const { return false; }
+
         virtual ~ILogHandler() = default;
 };
\ No newline at end of file
@@ -0,0 +1,725 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loglevel.h"
+#include "logfilters.h"
+#include "compositefilters.h"
+#include "logger.h"
+#include "loghandlers.h"
+#include "simpleformatter.h"
+#include "binarylog.h"
+#include <filesystem>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Счётчик выделений памяти для колонки "allocs/record": сколько раз на запись логгер
+// обращается к общему аллокатору (вместе со всеми его потоками)
+static std::atomic<std::uint64_t> g_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Строки, похожие на настоящий лог сервиса: большая часть не содержит искомых слов
+static std::vector<std::string> make_log_lines(std::size_t count)
+{
+    const char* templates[] = {
+        "GET /api/v1/users/%zu 200 12ms",
+        "cache miss for key session:%zu, loading from db",
+        "disk /dev/sda%zu almost full (93%%)",
+        "connection to 10.0.0.%zu:5432 refused, retrying",
+        "request %zu finished in 250ms",
+        "worker %zu picked job from queue payments",
+        "error 5%zu while writing checkpoint",
+        "user %zu logged in from 192.168.1.10",
+    };
+    const std::size_t template_count = sizeof(templates) / sizeof(templates[0]);
+
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    char buffer[128];
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        // Совпадающие строки встречаются реже: шаблоны 2, 3 и 6 — раз в восемь строк
+        std::size_t t = (i % 8 == 0) ? (i / 8) % template_count : (i % 2 == 0 ? 0 : (i % 3 == 0 ? 4 : 7));
+        std::snprintf(buffer, sizeof(buffer), templates[t], i % 100);
+        lines.emplace_back(buffer);
+    }
+    return lines;
+}
+
+template <typename Body>
+static double ns_per_op(std::size_t operations, Body&& body)
+{
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(operations);
+}
+
+// std::regex против предфильтра по обязательной подстроке на одних и тех же строках
+static void bench_regex_filter()
+{
+    const std::vector<std::string> lines = make_log_lines(4096);
+    const std::size_t rounds = 50;
+    const char* patterns[] = { "full", "disk.*full", R"(error \d+)", R"(refused|timeout)", R"(^GET /api/v\d/)" };
+
+    std::printf("ReLogFilter, ns per match over %zu lines:\n", lines.size());
+    std::printf("  %-22s %10s %12s %8s\n", "pattern", "std", "prefiltered", "speedup");
+
+    for (const char* pattern : patterns)
+    {
+        ReLogFilter std_filter(pattern, RegexEngine::Std);
+        ReLogFilter fast_filter(pattern, RegexEngine::Prefiltered);
+
+        std::size_t std_hits = 0;
+        std::size_t fast_hits = 0;
+        double std_ns = ns_per_op(lines.size() * rounds, [&]()
+        {
+            for (std::size_t r = 0; r < rounds; ++r)
+                for (const auto& line : lines) std_hits += std_filter.match(LogLevel::INFO, line);
+        });
+        double fast_ns = ns_per_op(lines.size() * rounds, [&]()
+        {
+            for (std::size_t r = 0; r < rounds; ++r)
+                for (const auto& line : lines) fast_hits += fast_filter.match(LogLevel::INFO, line);
+        });
+
+        std::printf("  %-22s %10.1f %12.1f %7.1fx%s\n", pattern, std_ns, fast_ns, std_ns / fast_ns,
+                    std_hits == fast_hits ? "" : "  (results differ!)");
+    }
+}
+
+// Много ключевых слов: один MultiPatternFilter против цикла по find() для каждого слова
+static void bench_multi_pattern_filter()
+{
+    const std::vector<std::string> lines = make_log_lines(4096);
+    const std::size_t rounds = 10;
+
+    std::printf("MultiPatternFilter (any of N), ns per match over %zu lines:\n", lines.size());
+    std::printf("  %-8s %12s %14s %8s\n", "N", "find loop", "aho-corasick", "speedup");
+
+    for (std::size_t keyword_count : { std::size_t{10}, std::size_t{200}, std::size_t{2000} })
+    {
+        std::vector<std::string> keywords;
+        for (std::size_t i = 0; i < keyword_count; ++i)
+        {
+            keywords.push_back("kw" + std::to_string(i * 7919 % 100000) + "_");
+        }
+        keywords.back() = "refused";
+
+        MultiPatternFilter filter(keywords, MatchMode::Any);
+
+        std::size_t loop_hits = 0;
+        std::size_t ac_hits = 0;
+        double loop_ns = ns_per_op(lines.size() * rounds, [&]()
+        {
+            for (std::size_t r = 0; r < rounds; ++r)
+                for (const auto& line : lines)
+                {
+                    bool hit = false;
+                    for (const auto& keyword : keywords)
+                    {
+                        if (line.find(keyword) != std::string::npos) { hit = true; break; }
+                    }
+                    loop_hits += hit;
+                }
+        });
+        double ac_ns = ns_per_op(lines.size() * rounds, [&]()
+        {
+            for (std::size_t r = 0; r < rounds; ++r)
+                for (const auto& line : lines) ac_hits += filter.match(LogLevel::INFO, line);
+        });
+
+        std::printf("  %-8zu %12.1f %14.1f %7.1fx%s\n", keyword_count, loop_ns, ac_ns, loop_ns / ac_ns,
+                    loop_hits == ac_hits ? "" : "  (results differ!)");
+    }
+}
+
+// Дорогой фильтр поставлен первым: AndFilter должен сам переставить дешёвый и избирательный вперёд
+static void bench_filter_ordering()
+{
+    const std::vector<std::string> lines = make_log_lines(4096);
+    const std::size_t rounds = 50;
+
+    auto make_children = []()
+    {
+        std::vector<std::unique_ptr<ILogFilter>> children;
+        children.push_back(std::make_unique<ReLogFilter>(R"(disk /dev/\w+ almost)", RegexEngine::Std));
+        children.push_back(std::make_unique<SimpleLogFilter>("disk"));
+        return children;
+    };
+
+    std::vector<std::unique_ptr<ILogFilter>> fixed = make_children();
+    AndFilter adaptive(make_children());
+
+    std::size_t fixed_hits = 0;
+    std::size_t adaptive_hits = 0;
+    double fixed_ns = ns_per_op(lines.size() * rounds, [&]()
+    {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (const auto& line : lines)
+            {
+                bool hit = true;
+                for (const auto& filter : fixed)
+                {
+                    if (!filter->match(LogLevel::INFO, line)) { hit = false; break; }
+                }
+                fixed_hits += hit;
+            }
+    });
+    double adaptive_ns = ns_per_op(lines.size() * rounds, [&]()
+    {
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (const auto& line : lines) adaptive_hits += adaptive.match(LogLevel::INFO, line);
+    });
+
+    std::printf("AndFilter ordering, ns per message: insertion order %.1f, adaptive %.1f%s\n",
+                fixed_ns, adaptive_ns, fixed_hits == adaptive_hits ? "" : "  (results differ!)");
+
+    std::vector<FilterStats> stats = adaptive.stats();
+    std::vector<std::size_t> order = adaptive.order();
+    for (std::size_t position = 0; position < order.size(); ++position)
+    {
+        const FilterStats& s = stats[order[position]];
+        std::printf("  #%zu filter %zu: accepted %llu, rejected %llu, %.1f ns avg\n", position, order[position],
+                    static_cast<unsigned long long>(s.accepted), static_cast<unsigned long long>(s.rejected), s.average_ns);
+    }
+}
+
+// Текст через SimpleFormatter и FileHandler против двоичной записи с отложенным форматированием
+static void bench_binary_log()
+{
+    const std::size_t records = 200000;
+    const std::string text_path = "logbench_text.log";
+    const std::string binary_path = "logbench_binary.blog";
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(binary_path);
+
+    double text_ns = 0.0;
+    {
+        std::vector<std::unique_ptr<ILogFormatter>> formatters;
+        formatters.push_back(std::make_unique<SimpleFormatter>());
+        std::vector<std::unique_ptr<ILogHandler>> handlers;
+        handlers.push_back(std::make_unique<FileHandler>(text_path));
+        Logger logger({}, std::move(formatters), std::move(handlers));
+
+        text_ns = ns_per_op(records, [&]()
+        {
+            for (std::size_t i = 0; i < records; ++i)
+                logger.log(LogLevel::INFO, "request {} from {} finished in {} ms", i, "10.0.0.7", 250);
+        });
+    }
+
+    double binary_ns = 0.0;
+    {
+        BinaryLogger logger(binary_path);
+        binary_ns = ns_per_op(records, [&]()
+        {
+            for (std::size_t i = 0; i < records; ++i)
+                logger.log(LogLevel::INFO, LOG_FORMAT("request {} from {} finished in {} ms"), i, "10.0.0.7", 250);
+        });
+    }
+
+    auto text_bytes = static_cast<double>(std::filesystem::file_size(text_path)) / static_cast<double>(records);
+    auto binary_bytes = static_cast<double>(std::filesystem::file_size(binary_path)) / static_cast<double>(records);
+    std::printf("Text vs binary log: %.1f ns, %.1f bytes per record (text) / %.1f ns, %.1f bytes (binary)\n",
+                text_ns, text_bytes, binary_ns, binary_bytes);
+
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(binary_path);
+}
+
+// Обрамление тегом: один вариант сливается в цепочку, другой работает через старый format()
+class TagFormatter : public IAffixFormatter
+{
+    public:
+
+        void append_prefix(LogLevel /*level*/, std::string& out) const override { out.append("[payments] "); }
+        void append_suffix(LogLevel /*level*/, std::string& out) const override { out.append(" #prod"); }
+};
+
+class LegacyTagFormatter : public ILogFormatter
+{
+    public:
+
+        std::string format(LogLevel /*level*/, const std::string& text) const override
+        {
+            return "[payments] " + text + " #prod";
+        }
+};
+
+// Три форматтера подряд: слитая цепочка против трёх отдельных проходов
+static void bench_formatter_chain()
+{
+    const std::vector<std::string> lines = make_log_lines(4096);
+    const std::size_t rounds = 100;
+
+    auto chain_ns = [&](bool fused)
+    {
+        std::vector<std::unique_ptr<ILogFormatter>> formatters;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (fused) formatters.push_back(std::make_unique<TagFormatter>());
+            else formatters.push_back(std::make_unique<LegacyTagFormatter>());
+        }
+        FormatterChain chain(std::move(formatters));
+
+        std::string front;
+        std::string back;
+        std::size_t checksum = 0;
+        double ns = ns_per_op(lines.size() * rounds, [&]()
+        {
+            for (std::size_t r = 0; r < rounds; ++r)
+                for (const auto& line : lines) checksum += chain.run(LogLevel::INFO, line, front, back).size();
+        });
+        if (checksum == 0) std::printf("unexpected\n");
+        return ns;
+    };
+
+    double separate = chain_ns(false);
+    double fused = chain_ns(true);
+    std::printf("Formatter chain of 3: %.1f ns separate, %.1f ns fused (%.2fx)\n", separate, fused, separate / fused);
+}
+
+// Цена времени в SimpleFormatter: system_clock на каждую запись, фоновый тикер и TSC
+static void bench_clock_sources()
+{
+    const std::size_t records = 2000000;
+    const std::string text = "request 42 finished in 250 ms";
+    std::printf("SimpleFormatter by clock source, ns per record:\n");
+
+    const std::pair<const char*, ClockOptions> sources[] = {
+        { "precise", ClockOptions{ClockMode::Precise} },
+        { "coarse 1ms", ClockOptions{ClockMode::Coarse, std::chrono::microseconds(1000)} },
+        { "tsc", ClockOptions{ClockMode::Tsc} },
+    };
+    for (const auto& [name, options] : sources)
+    {
+        SimpleFormatter formatter(options);
+        std::string out;
+        std::int64_t skew = options.mode == ClockMode::Precise ? 0 : LogClock(options).now_ns() - logclock::system_now_ns();
+        double ns = ns_per_op(records, [&]()
+        {
+            for (std::size_t i = 0; i < records; ++i) formatter.format_to(LogLevel::INFO, text, out);
+        });
+        std::printf("  %-12s %8.1f  (offset from system_clock %+.3f ms)\n", name, ns, static_cast<double>(skew) / 1e6);
+    }
+}
+
+// Консоль, перенаправленная в /dev/null: старый std::cout << std::endl против ConsoleHandler
+static void bench_console()
+{
+    const std::size_t records = 200000;
+    const std::string text = "2024-05-01 12:00:00.000 [INFO] request 42 finished in 250 ms";
+
+    int null_fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    int saved_fd = ::dup(STDOUT_FILENO);
+    if (null_fd < 0 || saved_fd < 0) return;
+    std::fflush(stdout);
+    ::dup2(null_fd, STDOUT_FILENO);
+
+    double endl_ns = ns_per_op(records, [&]()
+    {
+        for (std::size_t i = 0; i < records; ++i) std::cout << text << std::endl;
+    });
+
+    auto handler_ns = [&](ConsoleBuffering buffering, ConsoleColor color)
+    {
+        ConsoleOptions options;
+        options.buffering = buffering;
+        options.color = color;
+        ConsoleHandler handler(options);
+        return ns_per_op(records, [&]()
+        {
+            for (std::size_t i = 0; i < records; ++i) handler.handle(LogLevel::INFO, text);
+            handler.flush();
+        });
+    };
+    double line_ns = handler_ns(ConsoleBuffering::Line, ConsoleColor::Never);
+    double block_ns = handler_ns(ConsoleBuffering::Block, ConsoleColor::Never);
+    double color_ns = handler_ns(ConsoleBuffering::Block, ConsoleColor::Always);
+
+    ::dup2(saved_fd, STDOUT_FILENO);
+    ::close(saved_fd);
+    ::close(null_fd);
+    std::printf("Console to /dev/null, ns per record: %.1f cout+endl, %.1f line, %.1f block, %.1f block+color\n",
+                endl_ns, line_ns, block_ns, color_ns);
+}
+
+// Гистограмма задержек в наносекундах: до 16 нс точно, дальше по 16 корзин на каждую
+// степень двойки, то есть с погрешностью не больше 1/16. Память постоянная, запись — пара сдвигов
+class LatencyHistogram
+{
+    private:
+
+        static constexpr int kSubBits = 4;
+        static constexpr std::size_t kSub = std::size_t{1} << kSubBits;
+
+        std::vector<std::uint64_t> counts_ = std::vector<std::uint64_t>((64 - kSubBits + 1) * kSub, 0);
+        std::uint64_t total_ = 0;
+        std::uint64_t max_ = 0;
+        double sum_ = 0.0;
+
+        static std::size_t bucket(std::uint64_t ns)
+        {
+            if (ns < kSub) return static_cast<std::size_t>(ns);
+            int exponent = 63 - __builtin_clzll(ns);
+            auto sub = static_cast<std::size_t>(ns >> (exponent - kSubBits)) & (kSub - 1);
+            return static_cast<std::size_t>(exponent - kSubBits + 1) * kSub + sub;
+        }
+
+        // Нижняя граница корзины
+        static std::uint64_t lower_bound(std::size_t index)
+        {
+            if (index < kSub) return index;
+            int exponent = static_cast<int>(index / kSub) + kSubBits - 1;
+            return (std::uint64_t{1} << exponent) | (static_cast<std::uint64_t>(index % kSub) << (exponent - kSubBits));
+        }
+
+    public:
+
+        void record(std::uint64_t ns)
+        {
+            ++counts_[bucket(ns)];
+            ++total_;
+            sum_ += static_cast<double>(ns);
+            if (ns > max_) max_ = ns;
+        }
+
+        void merge(const LatencyHistogram& other)
+        {
+            for (std::size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+            total_ += other.total_;
+            sum_ += other.sum_;
+            if (other.max_ > max_) max_ = other.max_;
+        }
+
+        // q от 0 до 1; возвращает нижнюю границу корзины, в которую попал перцентиль
+        std::uint64_t percentile(double q) const
+        {
+            auto rank = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total_)));
+            if (rank == 0) rank = 1;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < counts_.size(); ++i)
+            {
+                seen += counts_[i];
+                if (seen >= rank) return lower_bound(i);
+            }
+            return max_;
+        }
+
+        std::uint64_t count() const { return total_; }
+        std::uint64_t max() const { return max_; }
+        double mean() const { return total_ ? sum_ / static_cast<double>(total_) : 0.0; }
+};
+
+// Обработчик, который ничего не делает: измеряется сам логгер, а не вывод
+class NullHandler : public ILogHandler
+{
+    public:
+
+        void handle(LogLevel /*level*/, const std::string& text) override
+        {
+            sink_ += text.size();
+        }
+
+    private:
+
+        std::size_t sink_ = 0;
+};
+
+struct SuiteResult
+{
+    std::string name;
+    std::size_t threads = 1;
+    std::size_t records = 0;
+    double seconds = 0.0;
+    double allocations_per_record = 0.0;
+    LatencyHistogram latency;
+};
+
+// Конфигурация логгера для сценария: фильтры, форматтеры и обработчики собираются заново на каждый прогон
+struct Scenario
+{
+    const char* name;
+    std::function<std::unique_ptr<Logger>()> make_logger;
+    LogLevel level; // уровень записей: ниже порога проверяется путь отсечения
+    bool with_args = false; // сообщение собирается из шаблона с аргументами, а не передаётся готовым
+};
+
+static const char* kSuiteFile = "logbench_suite.log";
+
+static std::vector<Scenario> make_scenarios()
+{
+    auto formatters = []()
+    {
+        std::vector<std::unique_ptr<ILogFormatter>> result;
+        result.push_back(std::make_unique<SimpleFormatter>());
+        return result;
+    };
+    auto null_handler = []()
+    {
+        std::vector<std::unique_ptr<ILogHandler>> result;
+        result.push_back(std::make_unique<NullHandler>());
+        return result;
+    };
+    auto file_handler = []()
+    {
+        std::vector<std::unique_ptr<ILogHandler>> result;
+        result.push_back(std::make_unique<FileHandler>(kSuiteFile));
+        return result;
+    };
+    auto filters = []()
+    {
+        std::vector<std::unique_ptr<ILogFilter>> result;
+        result.push_back(std::make_unique<LevelFilter>(LogLevel::WARN));
+        result.push_back(std::make_unique<SimpleLogFilter>("disk"));
+        result.push_back(std::make_unique<ReLogFilter>(R"(disk \S+ almost)"));
+        return result;
+    };
+
+    std::vector<Scenario> scenarios;
+    scenarios.push_back({"below_level", [=]()
+    {
+        auto logger = std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{}, formatters(), null_handler());
+        logger->set_level(LogLevel::INFO);
+        return logger;
+    }, LogLevel::DEBUG});
+    scenarios.push_back({"null_handler", [=]()
+    {
+        return std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{},
+                                        std::vector<std::unique_ptr<ILogFormatter>>{}, null_handler());
+    }, LogLevel::WARN});
+    scenarios.push_back({"formatter_null_handler", [=]()
+    {
+        return std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{}, formatters(), null_handler());
+    }, LogLevel::WARN});
+    scenarios.push_back({"filters_formatter_null_handler", [=]()
+    {
+        return std::make_unique<Logger>(filters(), formatters(), null_handler());
+    }, LogLevel::WARN});
+    scenarios.push_back({"formatter_file", [=]()
+    {
+        return std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{}, formatters(), file_handler());
+    }, LogLevel::WARN});
+    scenarios.push_back({"async_formatter_file", [=]()
+    {
+        return std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{}, formatters(), file_handler(),
+                                        AsyncOptions{65536, OverflowPolicy::Block, ClockOptions{}});
+    }, LogLevel::WARN});
+    scenarios.push_back({"args_formatter_null_handler", [=]()
+    {
+        return std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{}, formatters(), null_handler());
+    }, LogLevel::WARN, true});
+    scenarios.push_back({"async_args_formatter_null", [=]()
+    {
+        return std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{}, formatters(), null_handler(),
+                                        AsyncOptions{65536, OverflowPolicy::Block, ClockOptions{}});
+    }, LogLevel::WARN, true});
+    scenarios.push_back({"fanout_formatter_file_null", [=]()
+    {
+        std::vector<HandlerSpec> handlers = make_handler_specs(file_handler());
+        handlers.emplace_back(std::make_unique<NullHandler>());
+        return std::make_unique<Logger>(std::vector<std::unique_ptr<ILogFilter>>{}, formatters(), std::move(handlers),
+                                        FanOutOptions{2, 65536, OverflowPolicy::Block});
+    }, LogLevel::WARN});
+    return scenarios;
+}
+
+// Каждый поток пишет свою долю записей и меряет каждый вызов log();
+// пропускная способность — все записи за время от общего старта до конца последнего потока
+static SuiteResult run_scenario(const Scenario& scenario, std::size_t threads, std::size_t records,
+                                const std::vector<std::string>& lines)
+{
+    threads = std::min(threads, records); // на каждый поток хотя бы одна запись
+    SuiteResult result;
+    result.name = scenario.name;
+    result.threads = threads;
+    result.records = records / threads * threads;
+
+    std::filesystem::remove(kSuiteFile);
+    std::unique_ptr<Logger> logger = scenario.make_logger();
+    std::vector<LatencyHistogram> histograms(threads);
+    std::atomic<std::size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+
+    for (std::size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]()
+        {
+            LatencyHistogram& histogram = histograms[t];
+            std::size_t count = records / threads;
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const std::string& line = lines[(i + t * 131) % lines.size()];
+                auto start = std::chrono::steady_clock::now();
+                if (scenario.with_args) logger->log(scenario.level, "worker {} says: {}", t, line);
+                else logger->log(scenario.level, line);
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                histogram.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        });
+    }
+
+    while (ready.load() < threads) std::this_thread::yield();
+    std::uint64_t allocations_before = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) worker.join();
+    logger->flush(); // асинхронный режим считается законченным, когда всё записано
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.allocations_per_record = static_cast<double>(g_allocations.load() - allocations_before)
+                                  / static_cast<double>(result.records);
+
+    logger.reset();
+    std::filesystem::remove(kSuiteFile);
+    for (const auto& histogram : histograms) result.latency.merge(histogram);
+    return result;
+}
+
+// Цена самого замера: два вызова steady_clock::now() подряд
+static double clock_overhead_ns()
+{
+    const std::size_t samples = 1000000;
+    return ns_per_op(samples, [&]()
+    {
+        for (std::size_t i = 0; i < samples; ++i)
+        {
+            auto a = std::chrono::steady_clock::now();
+            auto b = std::chrono::steady_clock::now();
+            if (b < a) std::printf("clock went backwards\n");
+        }
+    });
+}
+
+static void write_suite_json(const std::vector<SuiteResult>& results, double overhead_ns, const char* path)
+{
+    std::FILE* out = std::fopen(path, "w");
+    if (!out)
+    {
+        std::perror(path);
+        return;
+    }
+
+    std::fprintf(out, "{\n  \"clock_overhead_ns\": %.1f,\n  \"hardware_threads\": %u,\n  \"results\": [\n",
+                 overhead_ns, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const SuiteResult& r = results[i];
+        std::fprintf(out,
+            "    {\"scenario\": \"%s\", \"threads\": %zu, \"records\": %zu, \"seconds\": %.6f, "
+            "\"records_per_second\": %.0f, \"allocs_per_record\": %.3f, \"latency_ns\": {\"mean\": %.1f, \"p50\": %llu, \"p99\": %llu, "
+            "\"p99_9\": %llu, \"max\": %llu}}%s\n",
+            r.name.c_str(), r.threads, r.records, r.seconds, static_cast<double>(r.records) / r.seconds,
+            r.allocations_per_record,
+            r.latency.mean(),
+            static_cast<unsigned long long>(r.latency.percentile(0.50)),
+            static_cast<unsigned long long>(r.latency.percentile(0.99)),
+            static_cast<unsigned long long>(r.latency.percentile(0.999)),
+            static_cast<unsigned long long>(r.latency.max()),
+            i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    std::fclose(out);
+}
+
+// Пропускная способность и задержка log() для разных сборок логгера, в одном и нескольких потоках
+static void bench_suite(std::size_t records, const char* json_path)
+{
+    const std::vector<std::string> lines = make_log_lines(4096);
+    std::size_t many = std::max<std::size_t>(4, std::min<std::size_t>(8, std::thread::hardware_concurrency()));
+    double overhead = clock_overhead_ns();
+
+    std::printf("Logger suite, %zu records per run (clock overhead %.1f ns included in latencies):\n", records, overhead);
+    std::printf("  %-32s %7s %12s %9s %9s %9s %9s %8s\n", "scenario", "threads", "records/s", "p50 ns", "p99 ns", "p99.9 ns", "max ns", "allocs");
+
+    std::vector<SuiteResult> results;
+    for (const Scenario& scenario : make_scenarios())
+    {
+        for (std::size_t threads : { std::size_t{1}, many })
+        {
+            SuiteResult r = run_scenario(scenario, threads, records, lines);
+            std::printf("  %-32s %7zu %12.0f %9llu %9llu %9llu %9llu %8.3f\n", r.name.c_str(), r.threads,
+                        static_cast<double>(r.records) / r.seconds,
+                        static_cast<unsigned long long>(r.latency.percentile(0.50)),
+                        static_cast<unsigned long long>(r.latency.percentile(0.99)),
+                        static_cast<unsigned long long>(r.latency.percentile(0.999)),
+                        static_cast<unsigned long long>(r.latency.max()), r.allocations_per_record);
+            results.push_back(std::move(r));
+        }
+    }
+
+    if (json_path)
+    {
+        write_suite_json(results, overhead, json_path);
+        std::printf("  written to %s\n", json_path);
+    }
+}
+
+// logbench [--json <файл>] [--records N] [--suite-only]
+int main(int argc, char** argv)
+{
+    const char* json_path = nullptr;
+    std::size_t records = 400000;
+    bool suite_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) json_path = argv[++i];
+        else if (std::strcmp(argv[i], "--records") == 0 && i + 1 < argc) records = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--suite-only") == 0) suite_only = true;
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--json <file>] [--records N] [--suite-only]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (records == 0)
+    {
+        std::fprintf(stderr, "--records must be positive\n");
+        return 2;
+    }
+
+    if (!suite_only)
+    {
+        bench_regex_filter();
+        bench_multi_pattern_filter();
+        bench_filter_ordering();
+        bench_binary_log();
+        bench_formatter_chain();
+        bench_clock_sources();
+        bench_console();
+    }
+    bench_suite(records, json_path);
+}
\ No newline at end of file
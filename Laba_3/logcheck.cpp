@@ -0,0 +1,296 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "loglevel.h"
+#include "logfilters.h"
+#include "compositefilters.h"
+#include "logger.h"
+#include "binarylog.h"
+#include "mappedring.h"
+#include "ratelimitfilter.h"
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <thread>
+
+// Самопроверки логгера, запускаются из ctest. Каждая проверка печатает расхождения
+// и возвращает их количество; программа завершается с ненулевым кодом, если они есть
+
+static int g_failures = 0;
+
+static void expect(bool condition, const char* what, const std::string& detail)
+{
+    if (condition) return;
+    ++g_failures;
+    std::printf("FAIL %s: %s\n", what, detail.c_str());
+}
+
+// Предфильтр ReLogFilter не должен менять ответ std::regex ни для одного шаблона
+static void check_regex_engines()
+{
+    const std::vector<std::string> patterns = {
+        "full", "disk.*full", R"(error \d+)", R"(refused|timeout)", R"(^GET /api/v\d/)",
+        R"(\x41BC)", R"(\x1b\[31m)", R"(ABC)", R"(\cJok)", R"(\u0041BC)", R"(a\vb)", R"(a\tb)", R"(\x4)",
+        R"(\bfull\b)", R"((ab)\1c)", R"(x\d\d)", R"([\x41-\x43]BC)", R"(\]x)", R"(\x2e\x2E)",
+        R"(AB?C)", R"(AB+C)", R"(AB{2}C)", R"(\.\*)", R"(a|\x62c)",
+    };
+    const std::vector<std::string> lines = {
+        "ABC", "xABCx", "\x1b[31mERROR\x1b[0m disk full", "line\nok", "a\tb", "ABBC", "AC",
+        "abab c", "ababc", "x12", "..", ".*", "bc", "disk almost full", "error 42", "refused",
+        "GET /api/v2/users", "]x", "\x04", "full",
+    };
+
+    for (const auto& pattern : patterns)
+    {
+        ReLogFilter std_filter(pattern, RegexEngine::Std);
+        ReLogFilter fast_filter(pattern, RegexEngine::Prefiltered);
+        for (const auto& line : lines)
+        {
+            bool expected = std_filter.match(LogLevel::INFO, line);
+            bool actual = fast_filter.match(LogLevel::INFO, line);
+            expect(expected == actual, "regex engines",
+                   "pattern '" + pattern + "' on '" + line + "': std=" + std::to_string(expected)
+                   + " prefiltered=" + std::to_string(actual));
+        }
+    }
+}
+
+// Фильтр с состоянием: считает дошедшие до него записи и пропускает все
+class CountingFilter : public ILogFilter
+{
+    private:
+
+        std::atomic<std::uint64_t>& seen_;
+        bool uses_text_;
+
+    public:
+
+        CountingFilter(std::atomic<std::uint64_t>& seen, bool uses_text) : seen_(seen), uses_text_(uses_text) {}
+
+        bool match(LogLevel /*level*/, const std::string& /*text*/) const override
+        {
+            seen_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool uses_text() const override { return uses_text_; }
+        bool reorderable() const override { return false; }
+};
+
+// Дешёвый фильтр без текста, отклоняющий всё: перестановка охотно подняла бы его вперёд
+class RejectAll : public ILogFilter
+{
+    public:
+
+        bool match(LogLevel /*level*/, const std::string& /*text*/) const override { return false; }
+        bool uses_text() const override { return false; }
+};
+
+class NullHandler : public ILogHandler
+{
+    public:
+
+        void handle(LogLevel /*level*/, const std::string& /*text*/) override {}
+};
+
+// Фильтр с состоянием видит те же записи, что и без перестановок: и в AndFilter, и в Logger
+static void check_stateful_filter_order()
+{
+    const std::uint64_t records = 20000;
+
+    std::atomic<std::uint64_t> seen{0};
+    std::vector<std::unique_ptr<ILogFilter>> children;
+    children.push_back(std::make_unique<SimpleLogFilter>(std::string("a")));
+    children.push_back(std::make_unique<CountingFilter>(seen, true));
+    children.push_back(std::make_unique<RejectAll>());
+    AndFilter filter(std::move(children));
+    const std::string text = "abc";
+    for (std::uint64_t i = 0; i < records; ++i) filter.match(LogLevel::INFO, text);
+    expect(seen.load() == records, "stateful filter in AndFilter",
+           "saw " + std::to_string(seen.load()) + " of " + std::to_string(records));
+    expect(!filter.reorderable(), "stateful filter in AndFilter", "composite should not be reorderable");
+
+    std::atomic<std::uint64_t> logged{0};
+    {
+        std::vector<std::unique_ptr<ILogFilter>> filters;
+        filters.push_back(std::make_unique<SimpleLogFilter>(std::string("a")));
+        filters.push_back(std::make_unique<CountingFilter>(logged, false));
+        filters.push_back(std::make_unique<RejectAll>());
+        filters.push_back(std::make_unique<LevelFilter>(LogLevel::ERROR));
+        std::vector<std::unique_ptr<ILogHandler>> handlers;
+        handlers.push_back(std::make_unique<NullHandler>());
+        Logger logger(std::move(filters), {}, std::move(handlers));
+        for (std::uint64_t i = 0; i < records; ++i) logger.log(LogLevel::INFO, "abc {}", i);
+        for (std::uint64_t i = 0; i < records; ++i) logger.log(LogLevel::INFO, "xyz {}", i);
+    }
+    expect(logged.load() == records, "stateful filter in Logger",
+           "saw " + std::to_string(logged.load()) + " of " + std::to_string(records));
+}
+
+// Расшифрованный двоичный журнал совпадает с тем, что logformat пишет в текстовый
+static void check_binary_log_round_trip()
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "logcheck_binary.logb").string();
+    std::filesystem::remove(path);
+
+    const float floats[] = { 0.1f, 1.0f / 3.0f, -2.5f, 1e-20f, 3.4e38f };
+    const double doubles[] = { 0.1, 1.0 / 3.0 };
+    std::vector<std::string> expected;
+    {
+        BinaryLogger logger(path);
+        for (float value : floats)
+        {
+            logger.log(LogLevel::INFO, LOG_FORMAT("float {} double {} int {}"), value, doubles[0], 7);
+            std::string line;
+            logformat::format_to(line, "float {} double {} int {}", value, doubles[0], 7);
+            expected.push_back(line);
+        }
+        logger.log(LogLevel::INFO, LOG_FORMAT("{} and {}"), doubles[1], 'x');
+        std::string line;
+        logformat::format_to(line, "{} and {}", doubles[1], 'x');
+        expected.push_back(line);
+        logger.flush();
+    }
+
+    BinaryLogReader reader;
+    expect(reader.open(path), "binary log round trip", "cannot open " + path);
+    BinaryLogReader::Record record;
+    std::size_t i = 0;
+    while (reader.next(record))
+    {
+        if (i < expected.size())
+        {
+            expect(record.text == expected[i], "binary log round trip", "'" + record.text + "' != '" + expected[i] + "'");
+        }
+        ++i;
+    }
+    expect(i == expected.size(), "binary log round trip",
+           "read " + std::to_string(i) + " of " + std::to_string(expected.size()) + " records");
+    std::filesystem::remove(path);
+}
+
+// Кольцо после многих кругов отдаёт только последние записи, подряд и без старых вперемешку
+static void check_mapped_ring_wrap()
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "logcheck_ring.bin").string();
+    std::filesystem::remove(path);
+
+    // Длины разные, чтобы хвост кольца пропускался на каждом круге в новом месте
+    auto text_of = [](std::uint64_t sequence)
+    {
+        return "record " + std::to_string(sequence) + " " + std::string(10 + (sequence * 37) % 300, 'x');
+    };
+
+    const std::uint64_t records = 600;
+    {
+        MappedRingFile ring(path, 4096);
+        expect(ring.is_open(), "mapped ring wrap", "cannot open " + path);
+        for (std::uint64_t i = 0; i < records; ++i)
+        {
+            ring.write(LogLevel::INFO, text_of(i));
+            if (i % 7 != 0 && i + 1 != records) continue;
+
+            std::vector<MappedRingFile::Record> read = MappedRingFile::read(path);
+            std::string where = "after " + std::to_string(i) + ": ";
+            if (read.empty())
+            {
+                expect(false, "mapped ring wrap", where + "nothing read");
+                continue;
+            }
+            expect(read.back().sequence == i, "mapped ring wrap",
+                   where + "last sequence " + std::to_string(read.back().sequence));
+            for (std::size_t k = 0; k < read.size(); ++k)
+            {
+                if (k > 0 && read[k].sequence != read[k - 1].sequence + 1)
+                {
+                    expect(false, "mapped ring wrap", where + "gap between " + std::to_string(read[k - 1].sequence)
+                                                      + " and " + std::to_string(read[k].sequence));
+                    break;
+                }
+                expect(read[k].text == text_of(read[k].sequence), "mapped ring wrap",
+                       where + "wrong text for " + std::to_string(read[k].sequence));
+            }
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+// Ограничитель пропускает то, что укладывается в rate, и не теряет счёт свёрнутых повторов
+static void check_rate_limit()
+{
+    using namespace std::chrono_literals;
+    std::map<std::string, std::uint64_t> summarized;
+    auto collect = [&summarized](LogLevel, const std::string& text, std::uint64_t count) { summarized[text] += count; };
+
+    // Сердцебиение 500 раз в секунду при пределе 1000 в секунду, между ударами — другие записи
+    {
+        RateLimitFilter filter({ 1000.0, 2.0, 4096, true, 5000ms }, collect);
+        int passed = 0;
+        const int beats = 100;
+        for (int i = 0; i < beats; ++i)
+        {
+            if (filter.match(LogLevel::INFO, "heartbeat")) ++passed;
+            filter.match(LogLevel::INFO, "work item " + std::to_string(i));
+            std::this_thread::sleep_for(2ms);
+        }
+        expect(passed == beats, "rate limit heartbeat", std::to_string(passed) + " of " + std::to_string(beats) + " passed");
+    }
+
+    // Два сообщения вперемешку: каждое ограничено своим ведром, а не считается повтором
+    {
+        RateLimitFilter filter({ 100.0, 5.0, 4096, true, 5000ms }, collect);
+        std::uint64_t passed_a = 0;
+        std::uint64_t passed_b = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < 300ms)
+        {
+            if (filter.match(LogLevel::INFO, "message A")) ++passed_a;
+            if (filter.match(LogLevel::INFO, "message B")) ++passed_b;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double allowed = 5.0 + 100.0 * seconds;
+        for (std::uint64_t passed : { passed_a, passed_b })
+        {
+            expect(passed >= 20 && static_cast<double>(passed) <= allowed + 1.0, "rate limit interleaved",
+                   std::to_string(passed) + " passed, about " + std::to_string(static_cast<int>(allowed)) + " allowed");
+        }
+    }
+
+    // Шторм одинаковых записей: проходит первая, счёт остальных отдаётся, как только пришла другая
+    summarized.clear();
+    {
+        RateLimitFilter filter({ 10.0, 50.0, 4096, true, 5000ms }, collect);
+        int passed = 0;
+        for (int i = 0; i < 1000; ++i) if (filter.match(LogLevel::ERROR, "storm")) ++passed;
+        expect(passed == 1, "rate limit storm", std::to_string(passed) + " of 1000 passed");
+        expect(summarized["storm"] == 0, "rate limit storm", "summary before the storm ended");
+        filter.match(LogLevel::ERROR, "after the storm");
+        expect(summarized["storm"] == 999, "rate limit storm", "summarized " + std::to_string(summarized["storm"]) + " of 999");
+    }
+
+    // Поток замолчал после шторма: сводку отдаёт запись другого потока через summary_interval
+    summarized.clear();
+    {
+        RateLimitFilter filter({ 10.0, 50.0, 4096, true, 50ms }, collect);
+        std::thread([&filter] { for (int i = 0; i < 100; ++i) filter.match(LogLevel::ERROR, "quiet storm"); }).join();
+        std::this_thread::sleep_for(120ms);
+        std::thread([&filter] { filter.match(LogLevel::INFO, "someone else"); }).join();
+        expect(summarized["quiet storm"] == 99, "rate limit timer",
+               "summarized " + std::to_string(summarized["quiet storm"]) + " of 99");
+    }
+}
+
+int main()
+{
+    check_regex_engines();
+    check_stateful_filter_order();
+    check_binary_log_round_trip();
+    check_mapped_ring_wrap();
+    check_rate_limit();
+
+    if (g_failures) std::printf("%d check(s) failed\n", g_failures);
+    else std::printf("all checks passed\n");
+    return g_failures ? 1 : 0;
+}
\ No newline at end of file
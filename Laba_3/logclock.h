@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// Откуда форматтер берёт время записи: точнее — дороже
+enum class ClockMode
+{
+    Precise,  // system_clock::now() на каждую запись
+    Coarse,   // значение, которое фоновый поток обновляет раз в resolution; чтение — одна загрузка
+    Tsc       // счётчик тактов процессора, пересчитанный в system_clock; без TSC — как Precise
+};
+
+struct ClockOptions
+{
+    ClockMode mode = ClockMode::Precise;
+    std::chrono::microseconds resolution{1000}; // только для Coarse
+};
+
+namespace logclock
+{
+    inline std::int64_t system_now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Один поток на процесс обновляет время с шагом, самым мелким среди тех, кому он нужен.
+    // Поток работает, пока есть хоть один пользователь
+    class Ticker
+    {
+        private:
+
+            std::atomic<std::int64_t> now_ns_{0};
+            std::mutex mutex_;
+            std::condition_variable changed_;
+            std::multiset<std::int64_t> resolutions_;   // шаги пользователей, нс
+            std::thread thread_;
+            bool running_ = false;
+
+            void run()
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!resolutions_.empty())
+                {
+                    auto step = std::chrono::nanoseconds(*resolutions_.begin());
+                    changed_.wait_for(lock, step);
+                    now_ns_.store(system_now_ns(), std::memory_order_relaxed);
+                }
+                running_ = false;
+            }
+
+        public:
+
+            static Ticker& instance()
+            {
+                static Ticker ticker;
+                return ticker;
+            }
+
+            void acquire(std::chrono::nanoseconds resolution)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                now_ns_.store(system_now_ns(), std::memory_order_relaxed);
+                resolutions_.insert(std::max<std::int64_t>(1000, resolution.count()));
+                if (!running_)
+                {
+                    // Прежний поток уже отпустил замок навсегда — осталось его дождаться
+                    if (thread_.joinable()) thread_.join();
+                    running_ = true;
+                    thread_ = std::thread([this] { run(); });
+                }
+                changed_.notify_one();
+            }
+
+            void release(std::chrono::nanoseconds resolution)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = resolutions_.find(std::max<std::int64_t>(1000, resolution.count()));
+                if (it != resolutions_.end()) resolutions_.erase(it);
+                changed_.notify_one();
+            }
+
+            ~Ticker()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    resolutions_.clear();
+                    changed_.notify_one();
+                }
+                if (thread_.joinable()) thread_.join();
+            }
+
+            std::int64_t now_ns() const { return now_ns_.load(std::memory_order_relaxed); }
+    };
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Время по TSC: ns = base_ns + (tsc - base_tsc) * ns_per_tick. Якорь пересчитывается
+    // раз в kAnchorEvery тем читателем, который первым это заметил; остальные читают его
+    // под seqlock и ничего не ждут. Частота уточняется по всему промежутку между якорями
+    class TscClock
+    {
+        private:
+
+            static constexpr std::int64_t kAnchorEvery = 1000000000; // 1 с
+
+            std::atomic<std::uint32_t> sequence_{0};
+            std::atomic<std::int64_t> base_ns_{0};
+            std::atomic<std::uint64_t> base_tsc_{0};
+            std::atomic<double> ns_per_tick_{0.0};
+            std::atomic<bool> anchoring_{false};
+            bool usable_ = false;
+
+            // Постоянная частота TSC (CPUID 0x80000007, EDX бит 8): иначе время по тактам врёт
+            static bool invariant_tsc()
+            {
+                unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+                if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) return false;
+                __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+                return (edx & (1u << 8)) != 0;
+            }
+
+            void store_anchor(std::int64_t ns, std::uint64_t tsc, double ns_per_tick)
+            {
+                sequence_.fetch_add(1, std::memory_order_acq_rel);
+                base_ns_.store(ns, std::memory_order_relaxed);
+                base_tsc_.store(tsc, std::memory_order_relaxed);
+                ns_per_tick_.store(ns_per_tick, std::memory_order_relaxed);
+                sequence_.fetch_add(1, std::memory_order_release);
+            }
+
+            // Первая калибровка — 10 мс один раз на процесс
+            TscClock()
+            {
+                if (!invariant_tsc()) return;
+                std::int64_t ns0 = system_now_ns();
+                std::uint64_t tsc0 = __rdtsc();
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                std::int64_t ns1 = system_now_ns();
+                std::uint64_t tsc1 = __rdtsc();
+                if (tsc1 <= tsc0 || ns1 <= ns0) return;
+                store_anchor(ns1, tsc1, static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0));
+                usable_ = true;
+            }
+
+            void reanchor(std::uint64_t tsc, std::int64_t old_ns, std::uint64_t old_tsc)
+            {
+                if (anchoring_.exchange(true, std::memory_order_acquire)) return;
+                std::int64_t ns = system_now_ns();
+                tsc = __rdtsc();
+                if (tsc > old_tsc && ns > old_ns)
+                {
+                    store_anchor(ns, tsc, static_cast<double>(ns - old_ns) / static_cast<double>(tsc - old_tsc));
+                }
+                anchoring_.store(false, std::memory_order_release);
+            }
+
+        public:
+
+            static TscClock& instance()
+            {
+                static TscClock clock;
+                return clock;
+            }
+
+            bool usable() const { return usable_; }
+
+            std::int64_t now_ns()
+            {
+                std::uint64_t tsc = __rdtsc();
+                for (;;)
+                {
+                    std::uint32_t before = sequence_.load(std::memory_order_acquire);
+                    std::int64_t base_ns = base_ns_.load(std::memory_order_acquire);
+                    std::uint64_t base_tsc = base_tsc_.load(std::memory_order_acquire);
+                    double ns_per_tick = ns_per_tick_.load(std::memory_order_acquire);
+                    if ((before & 1) || sequence_.load(std::memory_order_relaxed) != before) continue;
+
+                    auto elapsed = static_cast<std::int64_t>(static_cast<double>(tsc - base_tsc) * ns_per_tick);
+                    if (tsc < base_tsc) elapsed = 0; // другое ядро успело поставить якорь чуть позже
+                    if (elapsed > kAnchorEvery) reanchor(tsc, base_ns, base_tsc);
+                    return base_ns + elapsed;
+                }
+            }
+    };
+#endif
+}
+
+// Часы одного форматтера. Режим выбирается при создании; Coarse подключается
+// к общему фоновому потоку и отключается в деструкторе
+class LogClock
+{
+    private:
+
+        ClockOptions options_;
+
+    public:
+
+        explicit LogClock(ClockOptions options = {})
+            : options_(options)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if (options_.mode == ClockMode::Tsc && !logclock::TscClock::instance().usable())
+                options_.mode = ClockMode::Precise;
+#else
+            if (options_.mode == ClockMode::Tsc) options_.mode = ClockMode::Precise;
+#endif
+            if (options_.mode == ClockMode::Coarse) logclock::Ticker::instance().acquire(options_.resolution);
+        }
+
+        LogClock(const LogClock& other) : LogClock(other.options_) {}
+        LogClock& operator=(const LogClock&) = delete;
+
+        ~LogClock()
+        {
+            if (options_.mode == ClockMode::Coarse) logclock::Ticker::instance().release(options_.resolution);
+        }
+
+        // Наносекунды с начала эпохи, как у system_clock
+        std::int64_t now_ns() const
+        {
+            switch (options_.mode)
+            {
+                case ClockMode::Coarse:
+                    return logclock::Ticker::instance().now_ns();
+#if defined(__x86_64__) || defined(__i386__)
+                case ClockMode::Tsc:
+                    return logclock::TscClock::instance().now_ns();
+#endif
+                default:
+                    return logclock::system_now_ns();
+            }
+        }
+
+        ClockMode mode() const { return options_.mode; }
+};
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Простейший сборщик для проверки SocketHandler: принимает строки по TCP или UDP
+// на 127.0.0.1 и печатает их как есть: logcollector <порт> [udp]
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <port> [udp]\n", argv[0]);
+        return 2;
+    }
+
+    bool udp = argc > 2 && std::strcmp(argv[2], "udp") == 0;
+    int fd = ::socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<std::uint16_t>(std::atoi(argv[1])));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || (!udp && ::listen(fd, 16) != 0))
+    {
+        std::perror("bind");
+        return 1;
+    }
+
+    static char buffer[65536];
+    if (udp)
+    {
+        for (;;)
+        {
+            ssize_t size = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (size > 0) std::fwrite(buffer, 1, static_cast<std::size_t>(size), stdout);
+            std::fflush(stdout);
+        }
+    }
+
+    // Клиенты обслуживаются по очереди: логгер держит одно соединение
+    for (;;)
+    {
+        int client = ::accept(fd, nullptr, nullptr);
+        if (client < 0) continue;
+        ssize_t size;
+        while ((size = ::read(client, buffer, sizeof(buffer))) > 0)
+        {
+            std::fwrite(buffer, 1, static_cast<std::size_t>(size), stdout);
+        }
+        std::fflush(stdout);
+        ::close(client);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+#include "binarylog.h"
+
+// Превращает двоичный журнал BinaryLogger в текст того же вида, что даёт SimpleFormatter:
+// [LEVEL] [YYYY.MM.DD HH:MM:SS.mmm] [T<поток>] сообщение
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <binary log>\n", argv[0]);
+        return 2;
+    }
+
+    BinaryLogReader reader;
+    if (!reader.open(argv[1]))
+    {
+        std::fprintf(stderr, "%s: not a binary log\n", argv[1]);
+        return 1;
+    }
+
+    BinaryLogReader::Record record;
+    while (reader.next(record))
+    {
+        auto seconds = static_cast<std::time_t>(record.timestamp_ns / 1000000000u);
+        auto ms = static_cast<unsigned>(record.timestamp_ns / 1000000u % 1000u);
+
+        std::tm local{};
+        localtime_r(&seconds, &local);
+        char time_text[32];
+        std::strftime(time_text, sizeof(time_text), "%Y.%m.%d %H:%M:%S", &local);
+
+        std::printf("[%s] [%s.%03u] [T%u] %s\n", to_string(record.level), time_text, ms,
+                    static_cast<unsigned>(record.thread), record.text.c_str());
+    }
+}
\ No newline at end of file
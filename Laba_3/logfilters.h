@@ -2,24 +2,40 @@
 
 #include "ilogfilter.h"
 #include <string>
+#include <string_view>
 #include <regex> 
-#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
 
-// Фильтр по уровню лога
-class LevelFilter : public ILogFilter 
+// Фильтр по набору уровней: LevelSetFilter(levels_from(LogLevel::WARN)) — WARN и серьёзнее.
+// Logger распознаёт такие фильтры и проверяет маску сам, не вызывая match()
+class LevelSetFilter : public ILogFilter 
 {
     private:
 
-        LogLevel required_level_;
+        LevelMask levels_;
 
     public:
 
-        explicit LevelFilter(LogLevel level) : required_level_(level) {}
+        explicit LevelSetFilter(LevelMask levels) : levels_(levels) {}
 
         bool match(LogLevel level, const std::string& /*text*/) const override 
         {
-            return level == required_level_;
+            return (levels_ & level_bit(level)) != 0;
         }
+
+        bool uses_text() const override { return false; }
+
+        LevelMask levels() const { return levels_; }
+};
+
+// Фильтр по уровню лога: ровно один уровень
+class LevelFilter : public LevelSetFilter 
+{
+    public:
+
+        explicit LevelFilter(LogLevel level) : LevelSetFilter(level_bit(level)) {}
 };
 
 // Фильтр по наличию подстроки в тексте
@@ -38,7 +54,198 @@ class SimpleLogFilter : public ILogFilter
             return text.find(pattern_) != std::string::npos;
         }
 };
+
+
+// Сколько шаблонов MultiPatternFilter должно найтись в тексте
+enum class MatchMode
+{
+    Any,  // хотя бы один
+    All   // все
+};
+
+// Фильтр по набору подстрок (алгоритм Ахо — Корасик): все шаблоны ищутся
+// за один проход по тексту, время линейно по длине сообщения и не зависит от числа шаблонов
+class MultiPatternFilter : public ILogFilter 
+{
+    private:
+
+        static constexpr std::uint32_t kNone = 0xFFFFFFFFu;
+
+        MatchMode mode_;
+        std::size_t required_count_ = 0;   // сколько разных непустых шаблонов нужно для All
+        bool has_empty_ = false;           // пустой шаблон есть в любом тексте
+
+        // Байты, не встречающиеся ни в одном шаблоне, попадают в класс 0 — это сжимает таблицу
+        std::uint8_t byte_class_[256] = {};
+        std::size_t class_count_ = 1;
+
+        // Полная таблица переходов автомата: transitions_[state * class_count_ + class]
+        std::vector<std::uint32_t> transitions_;
+        std::vector<std::uint32_t> pattern_end_;  // номер шаблона, кончающегося в состоянии, или kNone
+        std::vector<std::uint32_t> output_link_;  // ближайшее по суффиксным ссылкам состояние с шаблоном
+        std::vector<std::uint8_t> accepting_;     // в состоянии или его суффиксе кончается шаблон
+
+        std::uint32_t next(std::uint32_t state, unsigned char byte) const
+        {
+            return transitions_[state * class_count_ + byte_class_[byte]];
+        }
+
+        void build(std::vector<std::string> patterns)
+        {
+            std::sort(patterns.begin(), patterns.end());
+            patterns.erase(std::unique(patterns.begin(), patterns.end()), patterns.end());
+
+            for (const auto& pattern : patterns)
+            {
+                if (pattern.empty())
+                {
+                    has_empty_ = true;
+                    continue;
+                }
+                for (char c : pattern)
+                {
+                    auto byte = static_cast<unsigned char>(c);
+                    if (byte_class_[byte] == 0)
+                    {
+                        if (class_count_ == 256) break; // встречаются все 256 байт — класс 0 пустует
+                        byte_class_[byte] = static_cast<std::uint8_t>(class_count_++);
+                    }
+                }
+            }
+
+            // Бор
+            transitions_.assign(class_count_, kNone);
+            pattern_end_.assign(1, kNone);
+            for (const auto& pattern : patterns)
+            {
+                if (pattern.empty()) continue;
+
+                std::uint32_t state = 0;
+                for (char c : pattern)
+                {
+                    std::size_t slot = state * class_count_ + byte_class_[static_cast<unsigned char>(c)];
+                    if (transitions_[slot] == kNone)
+                    {
+                        auto created = static_cast<std::uint32_t>(pattern_end_.size());
+                        transitions_[slot] = created;
+                        transitions_.resize(transitions_.size() + class_count_, kNone);
+                        pattern_end_.push_back(kNone);
+                    }
+                    state = transitions_[slot];
+                }
+                pattern_end_[state] = static_cast<std::uint32_t>(required_count_++);
+            }
+
+            // Обход в ширину: суффиксные ссылки и достраивание переходов до полного автомата
+            const std::size_t state_count = pattern_end_.size();
+            std::vector<std::uint32_t> fail(state_count, 0);
+            output_link_.assign(state_count, kNone);
+            accepting_.assign(state_count, 0);
+
+            std::vector<std::uint32_t> order;
+            order.reserve(state_count);
+            for (std::size_t cls = 0; cls < class_count_; ++cls)
+            {
+                std::uint32_t& child = transitions_[cls];
+                if (child == kNone)
+                {
+                    child = 0;
+                }
+                else
+                {
+                    order.push_back(child);
+                }
+            }
+
+            for (std::size_t head = 0; head < order.size(); ++head)
+            {
+                std::uint32_t state = order[head];
+                std::uint32_t link = fail[state];
+                output_link_[state] = pattern_end_[link] != kNone ? link : output_link_[link];
+                accepting_[state] = (pattern_end_[state] != kNone || accepting_[link]) ? 1 : 0;
+
+                for (std::size_t cls = 0; cls < class_count_; ++cls)
+                {
+                    std::uint32_t& child = transitions_[state * class_count_ + cls];
+                    std::uint32_t fallback = transitions_[link * class_count_ + cls];
+                    if (child == kNone)
+                    {
+                        child = fallback;
+                    }
+                    else
+                    {
+                        fail[child] = fallback;
+                        order.push_back(child);
+                    }
+                }
+            }
+        }
+
+        bool match_any(const std::string& text) const
+        {
+            std::uint32_t state = 0;
+            for (char c : text)
+            {
+                state = next(state, static_cast<unsigned char>(c));
+                if (accepting_[state]) return true;
+            }
+            return false;
+        }
+
+        bool match_all(const std::string& text) const
+        {
+            // Отметки найденных шаблонов: вместо очистки массива на каждый вызов
+            // увеличиваем номер прохода. Массив свой у каждого потока
+            thread_local std::vector<std::uint64_t> seen;
+            thread_local std::uint64_t pass = 0;
+            if (seen.size() < required_count_) seen.resize(required_count_, 0);
+            ++pass;
+
+            std::size_t found = 0;
+            std::uint32_t state = 0;
+            for (char c : text)
+            {
+                state = next(state, static_cast<unsigned char>(c));
+                if (!accepting_[state]) continue;
+
+                for (std::uint32_t s = pattern_end_[state] != kNone ? state : output_link_[state];
+                     s != kNone; s = output_link_[s])
+                {
+                    std::uint64_t& mark = seen[pattern_end_[s]];
+                    if (mark != pass)
+                    {
+                        mark = pass;
+                        if (++found == required_count_) return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+    public:
+
+        explicit MultiPatternFilter(std::vector<std::string> patterns, MatchMode mode = MatchMode::Any)
+            : mode_(mode)
+        {
+            build(std::move(patterns));
+        }
+
+        bool match(LogLevel /*level*/, const std::string& text) const override 
+        {
+            if (mode_ == MatchMode::Any)
+                return has_empty_ || match_any(text);
+
+            return required_count_ == 0 || match_all(text);
+        }
+};
    
+// Чем ReLogFilter проверяет текст
+enum class RegexEngine
+{
+    Std,          // всегда std::regex_search
+    Prefiltered   // сначала ищет обязательную подстроку шаблона и зовёт std::regex, только если она есть
+};
+
 // Фильтр по регулярному выражению 
 class ReLogFilter : public ILogFilter 
 {
@@ -46,24 +253,254 @@ class ReLogFilter : public ILogFilter
 
         std::regex pattern_;
         bool valid_ = true;  
+        RegexEngine engine_;
+
+        // Подстроки, без которых совпадения не бывает: по одной на каждую альтернативу
+        // верхнего уровня, хотя бы одна должна встретиться в тексте. Если шаблон состоит
+        // только из таких подстрок, std::regex не нужен вовсе
+        std::vector<std::string> required_;
+        bool pure_literal_ = false;
+
+        static bool is_special(char c)
+        {
+            return std::string_view("\\^$.|?*+()[]{}").find(c) != std::string_view::npos;
+        }
+
+        static bool is_quantifier(char c)
+        {
+            return c == '?' || c == '*' || c == '+' || c == '{';
+        }
+
+        static int hex_value(char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // Позиция за концом экранированной последовательности: \xHH, \uHHHH, \cX,
+        // обратная ссылка \12 или обычная пара из '\' и символа
+        static std::size_t skip_escape(std::string_view pattern, std::size_t i)
+        {
+            if (i + 1 >= pattern.size()) return pattern.size();
+
+            char escaped = pattern[i + 1];
+            std::size_t end = i + 2;
+            if (escaped == 'x') end = i + 4;
+            else if (escaped == 'u') end = i + 6;
+            else if (escaped == 'c') end = i + 3;
+            else if (escaped >= '1' && escaped <= '9')
+            {
+                while (end < pattern.size() && pattern[end] >= '0' && pattern[end] <= '9') ++end;
+            }
+            return std::min(end, pattern.size());
+        }
+
+        // Если последовательность обозначает ровно один символ, кладёт его в out.
+        // Классы (\d, \w...), границы слов, обратные ссылки и \cX (libstdc++ понимает его
+        // не так, как ECMAScript) литералом не считаются
+        static bool decode_escape(std::string_view escape, char& out)
+        {
+            if (escape.size() < 2) return false;
+
+            char escaped = escape[1];
+            if (escape.size() == 2)
+            {
+                if (is_special(escaped) || escaped == '/' || escaped == '-')
+                {
+                    out = escaped;
+                    return true;
+                }
+                const std::string_view controls = "fnrtv";
+                const char decoded[] = { '\f', '\n', '\r', '\t', '\v' };
+                std::size_t k = controls.find(escaped);
+                if (k == std::string_view::npos) return false;
+                out = decoded[k];
+                return true;
+            }
+
+            if ((escaped == 'x' && escape.size() == 4) || (escaped == 'u' && escape.size() == 6))
+            {
+                int value = 0;
+                for (char digit : escape.substr(2))
+                {
+                    int d = hex_value(digit);
+                    if (d < 0) return false;
+                    value = value * 16 + d;
+                }
+                if (value > 0xFF) return false; // в char такой символ не помещается
+                out = static_cast<char>(value);
+                return true;
+            }
+            return false;
+        }
+
+        // Позиция за концом конструкции, начинающейся с pattern[i]: класса [...],
+        // квантификатора {n,m}, экранированной последовательности или одного символа
+        static std::size_t skip_token(std::string_view pattern, std::size_t i)
+        {
+            char c = pattern[i];
+            if (c == '\\') return skip_escape(pattern, i);
+            if (c == '{')
+            {
+                std::size_t close = pattern.find('}', i);
+                return close == std::string_view::npos ? pattern.size() : close + 1;
+            }
+            if (c == '[')
+            {
+                // ']' сразу после '[' или '[^' — обычный символ
+                std::size_t j = i + 1;
+                if (j < pattern.size() && pattern[j] == '^') ++j;
+                if (j < pattern.size() && pattern[j] == ']') ++j;
+                while (j < pattern.size() && pattern[j] != ']')
+                {
+                    j = (pattern[j] == '\\') ? skip_escape(pattern, j) : j + 1;
+                }
+                return std::min(j + 1, pattern.size());
+            }
+            return i + 1;
+        }
+
+        // Консервативный разбор одной альтернативы: берём самую длинную цепочку обычных
+        // символов вне групп. Группы, классы и квантификаторы с нулём повторений обрывают цепочку.
+        // Возвращает true, если вся альтернатива — одна литеральная строка
+        static bool extract_required_literal(std::string_view branch, std::string& required)
+        {
+            std::string run;
+            int depth = 0;
+            bool pure = true;
+
+            auto close_run = [&]()
+            {
+                if (run.size() > required.size()) required = run;
+                run.clear();
+            };
+
+            std::size_t i = 0;
+            while (i < branch.size())
+            {
+                char c = branch[i];
+                char literal = 0;
+                bool is_literal = false;
+                std::size_t next = skip_token(branch, i);
+
+                if (c == '\\')
+                {
+                    is_literal = decode_escape(branch.substr(i, next - i), literal);
+                }
+                else if (c == '(')
+                {
+                    ++depth;
+                }
+                else if (c == ')')
+                {
+                    --depth;
+                }
+                else if (!is_special(c))
+                {
+                    literal = c;
+                    is_literal = true;
+                }
+
+                if (!is_literal || depth > 0)
+                {
+                    pure = false;
+                    close_run();
+                    i = next;
+                    continue;
+                }
+
+                char following = next < branch.size() ? branch[next] : '\0';
+                if (is_quantifier(following))
+                {
+                    pure = false;
+                    if (following == '+') run.push_back(literal); // хотя бы одно вхождение есть
+                    close_run();
+                }
+                else
+                {
+                    run.push_back(literal);
+                }
+                i = next;
+            }
+
+            close_run();
+            return pure && !required.empty();
+        }
+
+        // Делит шаблон по '|' верхнего уровня. Если хоть у одной альтернативы нет
+        // обязательной подстроки, предфильтр невозможен
+        void build_prefilter(std::string_view pattern)
+        {
+            std::vector<std::string_view> branches;
+            int depth = 0;
+            std::size_t begin = 0;
+            for (std::size_t i = 0; i < pattern.size(); i = skip_token(pattern, i))
+            {
+                if (pattern[i] == '(') ++depth;
+                else if (pattern[i] == ')') --depth;
+                else if (pattern[i] == '|' && depth == 0)
+                {
+                    branches.push_back(pattern.substr(begin, i - begin));
+                    begin = i + 1;
+                }
+            }
+            branches.push_back(pattern.substr(begin));
+
+            bool pure = true;
+            for (std::string_view branch : branches)
+            {
+                std::string required;
+                pure = extract_required_literal(branch, required) && pure;
+                if (required.empty())
+                {
+                    required_.clear();
+                    return;
+                }
+                required_.push_back(std::move(required));
+            }
+            pure_literal_ = pure;
+        }
 
     public:
 
-        explicit ReLogFilter(const std::string& pattern) 
+        explicit ReLogFilter(const std::string& pattern, RegexEngine engine = RegexEngine::Prefiltered) 
+            : engine_(engine)
         {
             try 
             {
-                pattern_ = std::regex(pattern);
+                pattern_ = std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
             } 
             catch (const std::regex_error&) 
             {
                 valid_ = false;  
             }
+
+            if (valid_ && engine_ == RegexEngine::Prefiltered)
+            {
+                build_prefilter(pattern);
+            }
         }
 
         bool match(LogLevel /*level*/, const std::string& text) const override 
         {
             if (!valid_) return false;
+
+            if (!required_.empty())
+            {
+                bool found = false;
+                for (const auto& literal : required_)
+                {
+                    if (text.find(literal) != std::string::npos)
+                    {
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) return false;
+                if (pure_literal_) return true;
+            }
             return std::regex_search(text, pattern_);
         }
 };
\ No newline at end of file
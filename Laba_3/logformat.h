@@ -0,0 +1,81 @@
+#pragma once
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Подстановка аргументов в шаблон вида "disk {} is {}% full".
+// "{{" и "}}" дают литеральные скобки; лишние {} остаются как есть, лишние аргументы игнорируются
+namespace logformat
+{
+    inline void append_arg(std::string& out, std::string_view value) { out.append(value); }
+    inline void append_arg(std::string& out, const char* value) { out.append(value ? value : "(null)"); }
+    inline void append_arg(std::string& out, const std::string& value) { out.append(value); }
+    inline void append_arg(std::string& out, char value) { out.push_back(value); }
+    inline void append_arg(std::string& out, bool value) { out.append(value ? "true" : "false"); }
+
+    template <typename T>
+    std::enable_if_t<std::is_arithmetic_v<T>> append_arg(std::string& out, T value)
+    {
+        char buffer[64];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+
+    // Дописывает кусок шаблона до следующего {} и возвращает остаток после него
+    inline std::string_view append_literal(std::string& out, std::string_view fmt, bool& found)
+    {
+        found = false;
+        std::size_t i = 0;
+        while (i < fmt.size())
+        {
+            char c = fmt[i];
+            if ((c == '{' || c == '}') && i + 1 < fmt.size() && fmt[i + 1] == c)
+            {
+                out.push_back(c);
+                i += 2;
+            }
+            else if (c == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}')
+            {
+                found = true;
+                return fmt.substr(i + 2);
+            }
+            else
+            {
+                out.push_back(c);
+                ++i;
+            }
+        }
+        return {};
+    }
+
+    inline void format_to(std::string& out, std::string_view fmt)
+    {
+        bool found = false;
+        while (!fmt.empty())
+        {
+            fmt = append_literal(out, fmt, found);
+            if (found) out.append("{}"); // аргументов не хватило
+        }
+    }
+
+    template <typename First, typename... Rest>
+    void format_to(std::string& out, std::string_view fmt, const First& first, const Rest&... rest)
+    {
+        bool found = false;
+        fmt = append_literal(out, fmt, found);
+        if (!found) return;
+        append_arg(out, first);
+        format_to(out, fmt, rest...);
+    }
+
+    template <typename... Args>
+    std::string format(std::string_view fmt, const Args&... args)
+    {
+        std::string out;
+        out.reserve(fmt.size() + 16 * sizeof...(Args));
+        format_to(out, fmt, args...);
+        return out;
+    }
+}
\ No newline at end of file
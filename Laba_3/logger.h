@@ -1,55 +1,912 @@
 #pragma once
 
 #include "ilogfilter.h"
+#include "compositefilters.h"
+#include "logfilters.h"
 #include "ilogformatter.h"
+#include "formatterchain.h"
 #include "iloghandler.h"
-#include <vector>
+#include "logformat.h"
+#include "ringbuffer.h"
+#include "logrecord.h"
+#include "logclock.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Что делать, если очередь асинхронного логгера заполнена
+enum class OverflowPolicy
+{
+    Block,       // ждать, пока фоновый поток освободит место
+    DropNewest,  // выбросить новую запись
+    DropOldest   // выбросить самую старую запись из очереди
+};
+
+struct AsyncOptions
+{
+    std::size_t capacity = 8192;
+    OverflowPolicy overflow = OverflowPolicy::Block;
+    ClockOptions clock;     // чем засекать время записи в log(): форматтеры получают его, а не время разбора очереди
+};
+
+// Параллельная раздача: у каждого обработчика своя очередь, handle() зовут потоки пула.
+// Медленный обработчик задерживает только свою очередь. По умолчанию при переполнении
+// запись для этого обработчика выбрасывается — Block заставил бы ждать всех
+struct FanOutOptions
+{
+    std::size_t workers = 2;
+    std::size_t capacity = 4096;                    // на каждый обработчик
+    OverflowPolicy overflow = OverflowPolicy::DropNewest;
+};
+
+// Счётчики логгера о самом себе. Обновляются на горячем пути только там, где и так держится
+// замок обработчика, поэтому стоят пару обычных записей в память. LOGGER_METRICS=0 (см. iloghandler.h)
+// убирает и их — так меряется цена счётчиков (цель LogBenchNoMetrics)
+
+struct HandlerMetrics
+{
+    std::uint64_t records = 0;      // сколько записей получил handle()
+    // Если обработчик отвечает на io_stats() — записанные им байты и все его записи на устройство.
+    // Иначе — длина полученных строк и только вызовы flush() логгером
+    std::uint64_t bytes = 0;
+    std::uint64_t flushes = 0;
+    double flush_average_ns = 0.0;
+    std::uint64_t flush_max_ns = 0;
+
+    // Только при параллельной раздаче
+    std::size_t queue_depth = 0;
+    std::uint64_t lag_ns = 0;       // сколько последняя запись ждала в очереди
+    std::uint64_t max_lag_ns = 0;
+    std::uint64_t dropped = 0;      // не поместились в очередь обработчика
+};
+
+struct LoggerMetrics
+{
+    std::vector<FilterStats> filters;   // как filter_stats()
+    std::vector<HandlerMetrics> handlers; // в порядке конструктора
+    std::uint64_t enqueued = 0;         // асинхронный режим: поставлено в очередь
+    std::uint64_t processed = 0;        // разобрано фоновым потоком
+    std::uint64_t dropped = 0;
+    std::size_t queue_depth = 0;
+    bool fanout = false;                // у обработчиков свои очереди — см. HandlerMetrics::queue_depth
+};
+
+// Обработчик со своими уровнями и своей цепочкой форматтеров. formatters == nullptr — общая
+// цепочка логгера. Обработчики, которым передан один и тот же объект цепочки, получают одну
+// и ту же строку: на запись она форматируется один раз
+struct HandlerSpec
+{
+    std::unique_ptr<ILogHandler> handler;
+    LevelMask levels = kAllLevels;
+    std::shared_ptr<const FormatterChain> formatters;
+
+    HandlerSpec(std::unique_ptr<ILogHandler> handler_ptr,
+                LevelMask level_mask = kAllLevels,
+                std::shared_ptr<const FormatterChain> chain = nullptr)
+        : handler(std::move(handler_ptr))
+        , levels(level_mask)
+        , formatters(std::move(chain))
+    {}
+
+    // Только записи уровня min_level и выше
+    HandlerSpec(std::unique_ptr<ILogHandler> handler_ptr,
+                LogLevel min_level,
+                std::shared_ptr<const FormatterChain> chain = nullptr)
+        : HandlerSpec(std::move(handler_ptr), levels_from(min_level), std::move(chain))
+    {}
+};
+
+// Обработчики без своих уровней и цепочек — для конструкторов, принимающих HandlerSpec
+inline std::vector<HandlerSpec> make_handler_specs(std::vector<std::unique_ptr<ILogHandler>> handlers)
+{
+    std::vector<HandlerSpec> specs;
+    specs.reserve(handlers.size());
+    for (auto& handler : handlers) specs.emplace_back(std::move(handler));
+    return specs;
+}
 
-class Logger 
+// Logger потокобезопасен: log() можно вызывать из нескольких потоков одновременно.
+// Фильтры и форматтеры должны быть потокобезопасны сами (их методы const),
+// обработчики Logger защищает сам
+class Logger
 {
-    private: 
+    private:
+
+        // Запись в очереди асинхронного режима. Текст лежит в записи из пула,
+        // так что постановка в очередь не обращается к аллокатору
+        struct QueuedRecord
+        {
+            RecordRef record;
+            std::int64_t timestamp_ns = 0;
+        };
+
+        // Фильтры объединяются по И. LevelSetFilter сворачиваются в битовую маску,
+        // остальные, которым не нужен текст, проверяются следующими, фильтры по тексту — последними.
+        // Внутри каждой группы порядок подстраивается по цене и избирательности
+        enum class FilterGroup { Mask, Level, Text };
+
+        std::vector<std::unique_ptr<ILogFilter>> mask_filters_;  // только владеем, match() не зовём
+        std::unique_ptr<AndFilter> level_filters_;
+        std::unique_ptr<AndFilter> text_filters_;
+        // filter_slots_[i] — где оказался i-й фильтр конструктора: группа и номер в ней
+        std::vector<std::pair<FilterGroup, std::size_t>> filter_slots_;
+        // Обработчики сгруппированы по цепочке форматтеров: группа форматирует запись один раз
+        // и раздаёт строку своим обработчикам, если запись проходит их уровни
+        struct HandlerGroup
+        {
+            std::shared_ptr<const FormatterChain> formatters;
+            LevelMask levels = 0; // объединение уровней обработчиков группы
+            std::vector<std::size_t> handlers;
+        };
 
-        std::vector<std::unique_ptr<ILogFilter>> filters_;
-        std::vector<std::unique_ptr<ILogFormatter>> formatters_;
         std::vector<std::unique_ptr<ILogHandler>> handlers_;
+        std::vector<LevelMask> handler_levels_;
+        std::vector<HandlerGroup> groups_;
+        LevelMask handler_mask_ = 0; // уровни, которые нужны хоть одному обработчику
+
+        // У каждого обработчика свой замок: потоки, пишущие одновременно, ждут друг друга
+        // только на одном и том же обработчике, а общего замка на весь логгер нет
+        std::unique_ptr<std::mutex[]> handler_locks_;
+
+        // Пишутся под замком своего обработчика, читаются без замка. Атомарные только ради
+        // чтения из metrics(): запись — обычные load и store, read-modify-write не нужен
+        struct alignas(64) HandlerCounters
+        {
+            std::atomic<std::uint64_t> records{0};
+            std::atomic<std::uint64_t> bytes{0};
+            std::atomic<std::uint64_t> flushes{0};
+            std::atomic<std::uint64_t> flush_ns{0};
+            std::atomic<std::uint64_t> flush_max_ns{0};
+            std::atomic<std::uint64_t> lag_ns{0};
+            std::atomic<std::uint64_t> max_lag_ns{0};
+        };
+        std::unique_ptr<HandlerCounters[]> handler_counters_;
+
+        static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t delta)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        // Порог, который можно менять на ходу, маска фильтров по уровню и уровни обработчиков
+        // сливаются в одну маску разрешённых уровней; она проверяется до того, как строится строка
+        std::atomic<LogLevel> min_level_{kCompiledMinLevel};
+        LevelMask filter_mask_ = kAllLevels;
+        std::atomic<LevelMask> enabled_mask_{levels_from(kCompiledMinLevel)};
+
+        // Асинхронный режим: очередь есть только если он включён
+        std::unique_ptr<RingBuffer<QueuedRecord>> queue_;
+        OverflowPolicy overflow_ = OverflowPolicy::Block;
+        std::unique_ptr<LogClock> record_clock_;
+        std::thread worker_;
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> worker_sleeping_{false};
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+        std::atomic<std::uint64_t> enqueued_{0};
+        std::atomic<std::uint64_t> processed_{0};
+        std::atomic<std::uint64_t> flushed_{0};
+        std::atomic<std::uint64_t> dropped_{0};
+
+        // Параллельная раздача: очередь на обработчик и общий пул потоков. Поток пула берёт
+        // обработчик с непустой очередью (флаг busy — одновременно его разбирает только один поток),
+        // отдаёт пачку записей и отпускает. Порядок записей для обработчика сохраняется
+        struct FanOutRecord
+        {
+            RecordRef record; // одна запись из пула на всех обработчиков группы
+            std::int64_t enqueued_ns = 0;
+        };
+
+        struct FanOutQueue
+        {
+            explicit FanOutQueue(std::size_t capacity) : records(capacity) {}
+
+            RingBuffer<FanOutRecord> records;
+            std::atomic<bool> busy{false};
+            std::atomic<bool> flush_requested{false};
+            std::atomic<std::size_t> flushed_pos{0};    // popped() на момент последнего flush()
+            std::atomic<std::uint64_t> dropped{0};
+        };
+
+        static constexpr std::size_t kFanOutBatch = 1024;
+
+        std::vector<std::unique_ptr<FanOutQueue>> fanout_;
+        OverflowPolicy fanout_overflow_ = OverflowPolicy::DropNewest;
+        std::vector<std::thread> fanout_workers_;
+        std::atomic<bool> fanout_stop_{false};
+        std::atomic<std::uint64_t> fanout_epoch_{0};    // растёт с каждой порцией работы для пула
+        std::atomic<int> fanout_sleeping_{0};
+        std::mutex fanout_mutex_;
+        std::condition_variable fanout_cv_;
+
+        // Буферы форматирования живут в потоке и переиспользуются между записями,
+        // поэтому в установившемся режиме цепочка форматтеров не выделяет память.
+        // Это же промежуточный буфер потока: запись собирается в нём целиком и только
+        // потом отдаётся обработчикам, так что строки разных потоков не перемешиваются
+        struct FormatBuffers
+        {
+            std::string front;
+            std::string back;
+            int depth = 0; // > 0, если обработчик сам пишет в лог из handle()
+        };
+
+        void handle(std::size_t i, LogLevel level, const std::string& formatted_text)
+        {
+            std::lock_guard<std::mutex> lock(handler_locks_[i]);
+            handlers_[i]->handle(level, formatted_text);
+#if LOGGER_METRICS
+            bump(handler_counters_[i].records, 1);
+            bump(handler_counters_[i].bytes, formatted_text.size());
+#endif
+        }
+
+        static constexpr int kMessageBuffers = 4;
+
+        struct MessageBuffers
+        {
+            std::string message[kMessageBuffers];
+            int depth = 0;
+        };
+
+        // Порядок записей одного потока сохраняется: поток отдаёт их по одной и дожидается handle()
+        void dispatch(const HandlerGroup& group, LogLevel level, const std::string& formatted_text)
+        {
+            if (!fanout_.empty())
+            {
+                dispatch_parallel(group, level, formatted_text);
+                return;
+            }
+
+            for (std::size_t i : group.handlers)
+            {
+                if ((handler_levels_[i] & level_bit(level)) == 0) continue;
+                handle(i, level, formatted_text);
+            }
+        }
+
+        static std::int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Кладёт запись в очереди обработчиков группы и будит пул, если он спит
+        void dispatch_parallel(const HandlerGroup& group, LogLevel level, const std::string& formatted_text)
+        {
+            RecordRef shared;
+            std::int64_t now = 0;
+            for (std::size_t i : group.handlers)
+            {
+                if ((handler_levels_[i] & level_bit(level)) == 0) continue;
+                if (!shared)
+                {
+                    shared = RecordRef::make(level, formatted_text);
+                    now = now_ns();
+                }
+
+                FanOutQueue& queue = *fanout_[i];
+                FanOutRecord record{shared, now};
+                while (!queue.records.try_push(std::move(record)))
+                {
+                    if (fanout_overflow_ == OverflowPolicy::DropNewest)
+                    {
+                        queue.dropped.fetch_add(1, std::memory_order_relaxed);
+                        break;
+                    }
+                    if (fanout_overflow_ == OverflowPolicy::DropOldest)
+                    {
+                        FanOutRecord victim;
+                        if (queue.records.try_pop(victim)) queue.dropped.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    wake_fanout();
+                    std::this_thread::yield();
+                }
+            }
+            if (shared) wake_fanout();
+        }
+
+        void wake_fanout()
+        {
+            fanout_epoch_.fetch_add(1, std::memory_order_seq_cst);
+            if (fanout_sleeping_.load(std::memory_order_seq_cst) > 0)
+            {
+                { std::lock_guard<std::mutex> lock(fanout_mutex_); }
+                fanout_cv_.notify_all();
+            }
+        }
+
+        // Пачка записей одного обработчика; false — работы не нашлось или обработчик занят
+        bool drain_handler(std::size_t i)
+        {
+            FanOutQueue& queue = *fanout_[i];
+            if (queue.records.size() == 0 && !queue.flush_requested.load(std::memory_order_acquire)) return false;
+            if (queue.busy.exchange(true, std::memory_order_acquire)) return false;
+
+            // Обработчики принимают std::string: текст копируется в буфер потока, он не выделяет память
+            thread_local std::string text;
+            FanOutRecord record;
+            std::size_t count = 0;
+            while (count < kFanOutBatch && queue.records.try_pop(record))
+            {
+                auto lag = static_cast<std::uint64_t>(std::max<std::int64_t>(0, now_ns() - record.enqueued_ns));
+                text.assign(record.record->text());
+                handle(i, record.record->level, text);
+                record.record.reset();
+                ++count;
+
+                HandlerCounters& counters = handler_counters_[i];
+                counters.lag_ns.store(lag, std::memory_order_relaxed);
+                if (lag > counters.max_lag_ns.load(std::memory_order_relaxed))
+                    counters.max_lag_ns.store(lag, std::memory_order_relaxed);
+            }
+
+            // Пачка кончилась вместе с очередью или flush() ждёт — отдаём накопленное на диск
+            bool requested = queue.flush_requested.exchange(false, std::memory_order_acq_rel);
+            if (requested || (count > 0 && queue.records.size() == 0))
+            {
+                flush_handler(i);
+                queue.flushed_pos.store(queue.records.popped(), std::memory_order_release);
+            }
+
+            queue.busy.store(false, std::memory_order_release);
+            return count > 0 || requested;
+        }
+
+        void fanout_loop()
+        {
+            for (;;)
+            {
+                std::uint64_t epoch = fanout_epoch_.load(std::memory_order_seq_cst);
+                bool worked = false;
+                for (std::size_t i = 0; i < fanout_.size(); ++i)
+                {
+                    worked |= drain_handler(i);
+                }
+                if (worked) continue;
+                if (fanout_stop_.load(std::memory_order_acquire)) return;
+
+                std::unique_lock<std::mutex> lock(fanout_mutex_);
+                fanout_sleeping_.fetch_add(1, std::memory_order_seq_cst);
+                if (fanout_epoch_.load(std::memory_order_seq_cst) == epoch && !fanout_stop_.load(std::memory_order_relaxed))
+                {
+                    fanout_cv_.wait_for(lock, std::chrono::milliseconds(50));
+                }
+                fanout_sleeping_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Просит пул сбросить обработчики, не дожидаясь этого
+        void request_fanout_flush()
+        {
+            for (auto& queue : fanout_) queue->flush_requested.store(true, std::memory_order_release);
+            wake_fanout();
+        }
+
+        // Ждёт, пока пул отдаст обработчикам и сбросит всё, что было в очередях на момент вызова
+        void flush_fanout()
+        {
+            std::vector<std::size_t> targets;
+            for (auto& queue : fanout_) targets.push_back(queue->records.pushed());
+            request_fanout_flush();
+            for (std::size_t i = 0; i < fanout_.size(); ++i)
+            {
+                while (fanout_[i]->flushed_pos.load(std::memory_order_acquire) < targets[i])
+                {
+                    fanout_[i]->flush_requested.store(true, std::memory_order_release);
+                    wake_fanout();
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        void start_fanout(const FanOutOptions& options)
+        {
+            for (std::size_t i = 0; i < handlers_.size(); ++i)
+            {
+                fanout_.push_back(std::make_unique<FanOutQueue>(options.capacity));
+            }
+            fanout_overflow_ = options.overflow;
+            for (std::size_t i = 0; i < std::max<std::size_t>(1, options.workers); ++i)
+            {
+                fanout_workers_.emplace_back([this] { fanout_loop(); });
+            }
+        }
+
+        void start_async(const AsyncOptions& options)
+        {
+            queue_ = std::make_unique<RingBuffer<QueuedRecord>>(options.capacity);
+            overflow_ = options.overflow;
+            record_clock_ = std::make_unique<LogClock>(options.clock);
+            worker_ = std::thread([this] { worker_loop(); });
+        }
+
+        // Форматирование и вывод — общая часть синхронного и асинхронного режимов.
+        // Синхронно время берут сами форматтеры, асинхронно — засечённое в log()
+        void write(LogLevel level, const std::string& text, std::int64_t timestamp_ns = FormatterChain::kNoTimestamp)
+        {
+            thread_local FormatBuffers buffers;
+
+            // Вложенный вызов: буферы заняты внешней записью, берём временные
+            std::string local_front;
+            std::string local_back;
+            bool nested = buffers.depth > 0;
+            std::string& front = nested ? local_front : buffers.front;
+            std::string& back = nested ? local_back : buffers.back;
+
+            ++buffers.depth;
+            for (const HandlerGroup& group : groups_)
+            {
+                if ((group.levels & level_bit(level)) == 0) continue;
+                dispatch(group, level, group.formatters->run(level, timestamp_ns, text, front, back));
+            }
+            --buffers.depth;
+        }
+
+        void flush_handler(std::size_t i)
+        {
+            std::lock_guard<std::mutex> lock(handler_locks_[i]);
+            auto start = std::chrono::steady_clock::now();
+            handlers_[i]->flush();
+            auto elapsed = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+            HandlerCounters& counters = handler_counters_[i];
+            bump(counters.flushes, 1);
+            bump(counters.flush_ns, elapsed);
+            if (elapsed > counters.flush_max_ns.load(std::memory_order_relaxed))
+                counters.flush_max_ns.store(elapsed, std::memory_order_relaxed);
+        }
+
+        // При параллельной раздаче обработчики сбрасывает пул: здесь только просьба
+        void flush_handlers()
+        {
+            if (!fanout_.empty())
+            {
+                request_fanout_flush();
+                return;
+            }
+            for (std::size_t i = 0; i < handlers_.size(); ++i) flush_handler(i);
+        }
+
+        void wake_worker()
+        {
+            if (worker_sleeping_.load(std::memory_order_seq_cst))
+            {
+                { std::lock_guard<std::mutex> lock(wake_mutex_); }
+                wake_cv_.notify_one();
+            }
+        }
+
+        void enqueue(LogLevel level, const std::string& text)
+        {
+            QueuedRecord record{RecordRef::make(level, text), record_clock_->now_ns()};
+
+            switch (overflow_)
+            {
+                case OverflowPolicy::Block:
+                    while (!queue_->try_push(std::move(record)))
+                    {
+                        wake_worker();
+                        std::this_thread::yield();
+                    }
+                    break;
+
+                case OverflowPolicy::DropNewest:
+                    if (!queue_->try_push(std::move(record)))
+                    {
+                        dropped_.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+                    break;
+
+                case OverflowPolicy::DropOldest:
+                    while (!queue_->try_push(std::move(record)))
+                    {
+                        QueuedRecord victim;
+                        if (queue_->try_pop(victim))
+                        {
+                            dropped_.fetch_add(1, std::memory_order_relaxed);
+                            processed_.fetch_add(1, std::memory_order_release);
+                        }
+                    }
+                    break;
+            }
+
+            enqueued_.fetch_add(1, std::memory_order_seq_cst);
+            wake_worker();
+        }
+
+        bool match_level(LogLevel level) const
+        {
+            static const std::string no_text;
+            return level_filters_->size() == 0 || level_filters_->match(level, no_text);
+        }
+
+        // Уровень уже проверен: остаются фильтры по тексту и вывод
+        void log_text(LogLevel level, const std::string& text)
+        {
+            if (text_filters_->size() != 0 && !text_filters_->match(level, text))
+                return; // сообщение отклонено
+
+            if (queue_)
+                enqueue(level, text);
+            else
+                write(level, text);
+        }
+
+        bool has_pending() const
+        {
+            return enqueued_.load(std::memory_order_seq_cst) > processed_.load(std::memory_order_acquire);
+        }
+
+        // Фоновый поток: разбирает очередь и прогоняет записи через форматтеры и обработчики
+        void worker_loop()
+        {
+            QueuedRecord record;
+            std::string text;
+            for (;;)
+            {
+                bool wrote = false;
+                while (queue_->try_pop(record))
+                {
+                    LogLevel level = record.record->level;
+                    text.assign(record.record->text());
+                    record.record.reset(); // запись вернётся в пул этого потока, а оттуда — пишущим
+                    write(level, text, record.timestamp_ns);
+                    processed_.fetch_add(1, std::memory_order_release);
+                    wrote = true;
+                }
+
+                // Очередь опустела — самое время отдать накопленную пачку на диск
+                std::uint64_t done = processed_.load(std::memory_order_acquire);
+                if (wrote || flushed_.load(std::memory_order_relaxed) < done)
+                {
+                    flush_handlers();
+                    flushed_.store(done, std::memory_order_release);
+                }
+
+                if (stop_.load(std::memory_order_acquire))
+                {
+                    if (!has_pending()) return;
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                worker_sleeping_.store(true, std::memory_order_seq_cst);
+                if (!has_pending() && !stop_.load(std::memory_order_relaxed))
+                {
+                    wake_cv_.wait_for(lock, std::chrono::milliseconds(50));
+                }
+                worker_sleeping_.store(false, std::memory_order_relaxed);
+            }
+        }
 
     public:
 
+        // У каждого обработчика свои уровни и, если нужно, своя цепочка форматтеров;
+        // formatters — общая цепочка для тех, кому своя не задана
+        Logger(
+            std::vector<std::unique_ptr<ILogFilter>> filters,
+            std::vector<std::unique_ptr<ILogFormatter>> formatters,
+            std::vector<HandlerSpec> handlers
+        )
+            : handler_locks_(new std::mutex[handlers.size()])
+            , handler_counters_(new HandlerCounters[handlers.size()])
+        {
+            auto common = std::make_shared<const FormatterChain>(std::move(formatters));
+            for (auto& spec : handlers)
+            {
+                const auto& chain = spec.formatters ? spec.formatters : common;
+                auto group = std::find_if(groups_.begin(), groups_.end(),
+                                          [&](const HandlerGroup& g) { return g.formatters == chain; });
+                if (group == groups_.end()) group = groups_.insert(groups_.end(), HandlerGroup{chain, 0, {}});
+
+                group->levels |= spec.levels;
+                group->handlers.push_back(handlers_.size());
+                handler_mask_ |= spec.levels;
+                handler_levels_.push_back(spec.levels);
+                handlers_.push_back(std::move(spec.handler));
+            }
+
+            // Фильтр с состоянием (reorderable() == false) должен видеть те же записи, что и в
+            // порядке конструктора. Поэтому всё, что идёт после него, в маску и группы раньше
+            // него не поднимается, а сам он уходит к фильтрам по тексту, если такие были до него
+            std::vector<std::unique_ptr<ILogFilter>> level_only;
+            std::vector<std::unique_ptr<ILogFilter>> by_text;
+            bool ordered = false;       // был фильтр с состоянием
+            bool ordered_text = false;  // и он (или следующий за ним) попал в группу Text
+            for (auto& filter : filters)
+            {
+                auto* level_set = dynamic_cast<const LevelSetFilter*>(filter.get());
+                if (level_set && !ordered)
+                {
+                    filter_mask_ &= level_set->levels();
+                    filter_slots_.emplace_back(FilterGroup::Mask, mask_filters_.size());
+                    mask_filters_.push_back(std::move(filter));
+                    continue;
+                }
+
+                bool text = filter->uses_text() || ordered_text || (!filter->reorderable() && !by_text.empty());
+                if (!filter->reorderable()) ordered = true;
+                if (ordered && text) ordered_text = true;
+
+                FilterGroup group = text ? FilterGroup::Text : FilterGroup::Level;
+                auto& target = group == FilterGroup::Text ? by_text : level_only;
+                filter_slots_.emplace_back(group, target.size());
+                target.push_back(std::move(filter));
+            }
+            level_filters_ = std::make_unique<AndFilter>(std::move(level_only));
+            text_filters_ = std::make_unique<AndFilter>(std::move(by_text));
+            set_level(min_level_.load(std::memory_order_relaxed));
+        }
+
+        // Все обработчики получают все уровни и общую цепочку форматтеров
         Logger(
             std::vector<std::unique_ptr<ILogFilter>> filters,
             std::vector<std::unique_ptr<ILogFormatter>> formatters,
             std::vector<std::unique_ptr<ILogHandler>> handlers
-        ) 
-            : filters_(std::move(filters))
-            , formatters_(std::move(formatters))
-            , handlers_(std::move(handlers))
+        )
+            : Logger(std::move(filters), std::move(formatters), make_handler_specs(std::move(handlers)))
         {}
-  
-   
-        void log(LogLevel level, const std::string& text) 
+
+        // Асинхронный режим: log() только кладёт запись в очередь,
+        // форматтеры и обработчики работают в отдельном потоке
+        Logger(
+            std::vector<std::unique_ptr<ILogFilter>> filters,
+            std::vector<std::unique_ptr<ILogFormatter>> formatters,
+            std::vector<HandlerSpec> handlers,
+            AsyncOptions options
+        )
+            : Logger(std::move(filters), std::move(formatters), std::move(handlers))
         {
-            for (const auto& filter : filters_) 
+            start_async(options);
+        }
+
+        // Параллельная раздача обработчикам на пуле потоков
+        Logger(
+            std::vector<std::unique_ptr<ILogFilter>> filters,
+            std::vector<std::unique_ptr<ILogFormatter>> formatters,
+            std::vector<HandlerSpec> handlers,
+            FanOutOptions fanout
+        )
+            : Logger(std::move(filters), std::move(formatters), std::move(handlers))
+        {
+            start_fanout(fanout);
+        }
+
+        // Асинхронный режим вместе с параллельной раздачей: фоновый поток форматирует
+        // и раскладывает записи по очередям обработчиков
+        Logger(
+            std::vector<std::unique_ptr<ILogFilter>> filters,
+            std::vector<std::unique_ptr<ILogFormatter>> formatters,
+            std::vector<HandlerSpec> handlers,
+            AsyncOptions options,
+            FanOutOptions fanout
+        )
+            : Logger(std::move(filters), std::move(formatters), std::move(handlers))
+        {
+            start_fanout(fanout);
+            start_async(options);
+        }
+
+        Logger(
+            std::vector<std::unique_ptr<ILogFilter>> filters,
+            std::vector<std::unique_ptr<ILogFormatter>> formatters,
+            std::vector<std::unique_ptr<ILogHandler>> handlers,
+            AsyncOptions options
+        )
+            : Logger(std::move(filters), std::move(formatters), make_handler_specs(std::move(handlers)), options)
+        {}
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        // Перед разрушением дописывает всё, что осталось в очередях
+        ~Logger()
+        {
+            if (worker_.joinable())
+            {
+                stop_.store(true, std::memory_order_release);
+                { std::lock_guard<std::mutex> lock(wake_mutex_); }
+                wake_cv_.notify_one();
+                worker_.join();
+            }
+
+            if (!fanout_workers_.empty())
+            {
+                fanout_stop_.store(true, std::memory_order_release);
+                wake_fanout();
+                for (auto& worker : fanout_workers_) worker.join();
+            }
+        }
+
+        void log(LogLevel level, const std::string& text)
+        {
+            if (!is_enabled(level) || !match_level(level)) return;
+            log_text(level, text);
+        }
+
+        // Отложенное сообщение: make_message вызывается, только если уровень прошёл
+        // порог и фильтры по уровню. Фильтрам по тексту текст, конечно, нужен — они идут после
+        template <typename MakeMessage,
+                  typename = std::enable_if_t<std::is_invocable_v<MakeMessage&>>>
+        void log(LogLevel level, MakeMessage&& make_message)
+        {
+            if (!is_enabled(level) || !match_level(level)) return;
+            log_text(level, std::string(make_message()));
+        }
+
+        // Шаблон с аргументами в стиле {}: log(LogLevel::WARN, "disk {} is {}% full", name, pct).
+        // Строка собирается, только если уровень прошёл порог и фильтры по уровню
+        template <typename First, typename... Rest>
+        void log(LogLevel level, std::string_view fmt, const First& first, const Rest&... rest)
+        {
+            if (!is_enabled(level) || !match_level(level)) return;
+
+            // Строка собирается в буфере потока; пока обработчик, сам пишущий в лог,
+            // не займёт все kMessageBuffers, память не выделяется
+            thread_local MessageBuffers buffers;
+            if (buffers.depth >= kMessageBuffers)
             {
-                if (!filter->match(level, text))           
-                    return; // сообщение отклонено       
+                log_text(level, logformat::format(fmt, first, rest...));
+                return;
             }
 
-      
-            std::string formatted_text = text;
-            for (const auto& formatter : formatters_) 
+            std::string& message = buffers.message[buffers.depth++];
+            message.clear();
+            logformat::format_to(message, fmt, first, rest...);
+            log_text(level, message);
+            --buffers.depth;
+        }
+
+        // Уровень ниже порога отсекается прежде, чем аргумент превратится в std::string.
+        // Если Level ниже порога компиляции, от вызова не остаётся ничего
+        template <LogLevel Level, typename... Args>
+        void log_at(Args&&... args)
+        {
+            if constexpr (Level >= kCompiledMinLevel)
             {
-                formatted_text = formatter->format(level, formatted_text);
+                if (is_enabled(Level))
+                    log(Level, std::forward<Args>(args)...);
             }
+        }
 
-     
-            for (const auto& handler : handlers_) 
+        // Одна загрузка и одна битовая проверка, без обращения к объектам фильтров
+        bool is_enabled(LogLevel level) const
+        {
+            return level >= kCompiledMinLevel
+                && (enabled_mask_.load(std::memory_order_relaxed) & level_bit(level)) != 0;
+        }
+
+        void set_level(LogLevel level)
+        {
+            min_level_.store(level, std::memory_order_relaxed);
+            enabled_mask_.store(levels_from(level) & filter_mask_ & handler_mask_, std::memory_order_relaxed);
+        }
+
+        LogLevel level() const { return min_level_.load(std::memory_order_relaxed); }
+
+        // Сбрасывает буферы обработчиков; в асинхронном режиме сначала ждёт,
+        // пока фоновый поток обработает всё, что было поставлено в очередь до вызова
+        void flush()
+        {
+            if (queue_)
             {
-                handler->handle(level, formatted_text);
+                std::uint64_t target = enqueued_.load(std::memory_order_relaxed);
+                while (flushed_.load(std::memory_order_acquire) < target)
+                {
+                    wake_worker();
+                    std::this_thread::yield();
+                }
             }
+
+            if (!fanout_.empty())
+                flush_fanout();
+            else if (!queue_)
+                flush_handlers();
         }
 
-        void log_info(const std::string& text)  { log(LogLevel::INFO,  text); }
-        void log_warn(const std::string& text)  { log(LogLevel::WARN,  text); }
-        void log_error(const std::string& text) { log(LogLevel::ERROR, text); }
-};
\ No newline at end of file
+        // Статистика фильтров в порядке, в котором они были переданы в конструктор.
+        // LevelSetFilter проверяются маской и счётчиков не ведут — у них нули
+        std::vector<FilterStats> filter_stats() const
+        {
+            std::vector<FilterStats> level_stats = level_filters_->stats();
+            std::vector<FilterStats> text_stats = text_filters_->stats();
+            std::vector<FilterStats> result;
+            for (const auto& [group, index] : filter_slots_)
+            {
+                switch (group)
+                {
+                    case FilterGroup::Mask:  result.emplace_back(); break;
+                    case FilterGroup::Level: result.push_back(level_stats[index]); break;
+                    case FilterGroup::Text:  result.push_back(text_stats[index]); break;
+                }
+            }
+            return result;
+        }
+
+        // Снимок счётчиков без остановки логгера: отдельные числа могут отставать друг от друга
+        LoggerMetrics metrics() const
+        {
+            LoggerMetrics result;
+            result.filters = filter_stats();
+            for (std::size_t i = 0; i < handlers_.size(); ++i)
+            {
+                const HandlerCounters& counters = handler_counters_[i];
+                HandlerMetrics handler;
+                handler.records = counters.records.load(std::memory_order_relaxed);
+                handler.bytes = counters.bytes.load(std::memory_order_relaxed);
+                handler.flushes = counters.flushes.load(std::memory_order_relaxed);
+                handler.flush_max_ns = counters.flush_max_ns.load(std::memory_order_relaxed);
+                if (!fanout_.empty())
+                {
+                    handler.queue_depth = fanout_[i]->records.size();
+                    handler.dropped = fanout_[i]->dropped.load(std::memory_order_relaxed);
+                    handler.lag_ns = counters.lag_ns.load(std::memory_order_relaxed);
+                    handler.max_lag_ns = counters.max_lag_ns.load(std::memory_order_relaxed);
+                }
+                std::uint64_t flush_ns = counters.flush_ns.load(std::memory_order_relaxed);
+
+                HandlerIoStats io;
+                if (handlers_[i]->io_stats(io))
+                {
+                    handler.bytes = io.bytes;
+                    handler.flushes = io.flushes;
+                    handler.flush_max_ns = io.flush_max_ns;
+                    flush_ns = io.flush_ns;
+                }
+                if (handler.flushes)
+                {
+                    handler.flush_average_ns = static_cast<double>(flush_ns) / static_cast<double>(handler.flushes);
+                }
+                result.handlers.push_back(handler);
+            }
+            result.enqueued = enqueued_.load(std::memory_order_relaxed);
+            result.processed = processed_.load(std::memory_order_relaxed);
+            result.dropped = dropped_count();
+            result.queue_depth = queue_depth();
+            result.fanout = is_fanout();
+            return result;
+        }
+
+        bool is_async() const { return queue_ != nullptr; }
+        std::uint64_t dropped_count() const { return dropped_.load(std::memory_order_relaxed); }
+        std::size_t queue_depth() const { return queue_ ? queue_->size() : 0; }
+        bool is_fanout() const { return !fanout_.empty(); }
+
+        // Принимают то же, что и log(): строку, функцию, возвращающую строку, или шаблон с аргументами
+        template <typename... Args> void log_trace(Args&&... args) { log_at<LogLevel::TRACE>(std::forward<Args>(args)...); }
+        template <typename... Args> void log_debug(Args&&... args) { log_at<LogLevel::DEBUG>(std::forward<Args>(args)...); }
+        template <typename... Args> void log_info(Args&&... args)  { log_at<LogLevel::INFO>(std::forward<Args>(args)...); }
+        template <typename... Args> void log_warn(Args&&... args)  { log_at<LogLevel::WARN>(std::forward<Args>(args)...); }
+        template <typename... Args> void log_error(Args&&... args) { log_at<LogLevel::ERROR>(std::forward<Args>(args)...); }
+        template <typename... Args> void log_fatal(Args&&... args) { log_at<LogLevel::FATAL>(std::forward<Args>(args)...); }
+};
+
+// Макросы не вычисляют выражение с сообщением вовсе, если уровень отключён —
+// ни при компиляции, ни во время работы: LOG_INFO(logger, "free: " + std::to_string(n))
+#define LOG_AT(logger, level, ...)                                              \
+    do                                                                          \
+    {                                                                           \
+        if constexpr (LogLevel::level >= kCompiledMinLevel)                     \
+        {                                                                       \
+            if ((logger).is_enabled(LogLevel::level))                           \
+                (logger).log(LogLevel::level, __VA_ARGS__);                     \
+        }                                                                       \
+    } while (false)
+
+#define LOG_TRACE(logger, ...) LOG_AT(logger, TRACE, __VA_ARGS__)
+#define LOG_DEBUG(logger, ...) LOG_AT(logger, DEBUG, __VA_ARGS__)
+#define LOG_INFO(logger, ...)  LOG_AT(logger, INFO,  __VA_ARGS__)
+#define LOG_WARN(logger, ...)  LOG_AT(logger, WARN,  __VA_ARGS__)
+#define LOG_ERROR(logger, ...) LOG_AT(logger, ERROR, __VA_ARGS__)
+#define LOG_FATAL(logger, ...) LOG_AT(logger, FATAL, __VA_ARGS__)
@@ -1,42 +1,179 @@
 #pragma once
 
 #include "iloghandler.h"
-#include <iostream>
-#include <fstream>
+#include "filewriter.h"
+#include "rotation.h"
+#include "mappedring.h"
+#include "socketsender.h"
+#include <atomic>
+#include <cstdlib>
 #include <string>
+#include <string_view>
+#include <unistd.h>
 #include <filesystem>
 
 
-// Вывод лога в консоль
+enum class ConsoleBuffering
+{
+    Auto,   // терминал — построчно, файл или канал — блоками
+    Line,   // каждая запись сразу уходит одним write()
+    Block   // сброс по заполнению, по таймеру и на уровне flush_level
+};
+
+enum class ConsoleColor
+{
+    Auto,   // цвет только в терминал, если не задан NO_COLOR и TERM не "dumb"
+    Always,
+    Never
+};
+
+struct ConsoleOptions
+{
+    int fd = STDOUT_FILENO;
+    ConsoleBuffering buffering = ConsoleBuffering::Auto;
+    ConsoleColor color = ConsoleColor::Auto;
+    FileBufferOptions buffer;    // размер блока, интервал сброса, уровень немедленного сброса
+};
+
+// Вывод лога в консоль. Пишет прямо в дескриптор мимо std::cout: строки копятся в буфере
+// и уходят целыми пачками, поэтому не перемешиваются с выводом других потоков и процессов
 class ConsoleHandler : public ILogHandler 
 {
+    private:
+
+        BufferedFileWriter writer_;
+        bool color_;
+
+        static bool is_tty(int fd) { return ::isatty(fd) == 1; }
+
+        static bool use_color(const ConsoleOptions& options)
+        {
+            if (options.color != ConsoleColor::Auto) return options.color == ConsoleColor::Always;
+            if (!is_tty(options.fd) || std::getenv("NO_COLOR")) return false;
+            const char* term = std::getenv("TERM");
+            return term && std::string_view(term) != "dumb";
+        }
+
+        static FileBufferOptions buffer_options(const ConsoleOptions& options)
+        {
+            FileBufferOptions buffer = options.buffer;
+            bool line = options.buffering == ConsoleBuffering::Line
+                     || (options.buffering == ConsoleBuffering::Auto && is_tty(options.fd));
+            if (line) buffer.flush_level = LogLevel::TRACE; // любой уровень сбрасывает буфер
+            return buffer;
+        }
+
+        // Строковые литералы: на запись цвет ничего не выделяет
+        static std::string_view color_of(LogLevel level)
+        {
+            switch (level)
+            {
+                case LogLevel::TRACE: return "\x1b[90m";
+                case LogLevel::DEBUG: return "\x1b[36m";
+                case LogLevel::INFO:  return "\x1b[32m";
+                case LogLevel::WARN:  return "\x1b[33m";
+                case LogLevel::ERROR: return "\x1b[31m";
+                case LogLevel::FATAL: return "\x1b[1;31m";
+            }
+            return {};
+        }
+
     public:
 
-        void handle(LogLevel /*level*/, const std::string& text) override 
+        explicit ConsoleHandler(ConsoleOptions options = {})
+            : writer_(options.fd, options.fd == STDERR_FILENO ? "<stderr>" : "<stdout>", buffer_options(options))
+            , color_(use_color(options)) {}
+
+        void handle(LogLevel level, const std::string& text) override 
+        {
+            if (color_) writer_.write(level, color_of(level), text, "\x1b[0m\n");
+            else writer_.write(level, {}, text);
+        }
+
+        void flush() override { writer_.flush(); }
+
+        bool io_stats(HandlerIoStats& stats) const override { return writer_.io_stats(stats); }
+};
+
+// Просьбы переоткрыть файл или начать новый сегмент. Приходят из любого потока (например,
+// по SIGHUP), а выполняются в handle() и flush(), которые Logger зовёт под замком обработчика:
+// писатель трогает только тот поток, что сейчас пишет
+class RotationRequests
+{
+    private:
+
+        std::atomic<bool> reopen_{false};
+        std::atomic<bool> rotate_{false};
+
+    public:
+
+        void reopen() { reopen_.store(true, std::memory_order_release); }
+        void rotate() { rotate_.store(true, std::memory_order_release); }
+
+        void apply(RotatingFileWriter& writer)
         {
-            std::cout << text << std::endl;
+            if (rotate_.load(std::memory_order_relaxed) && rotate_.exchange(false, std::memory_order_acq_rel))
+                writer.rotate();
+            if (reopen_.load(std::memory_order_relaxed) && reopen_.exchange(false, std::memory_order_acq_rel))
+                writer.reopen();
         }
 };
 
-// Запись лога в файл
+// Запись лога в файл, по желанию с ротацией по размеру и времени
 class FileHandler : public ILogHandler 
 {
     private: 
 
-        std::string file_path_;
+        RotatingFileWriter writer_;
+        RotationRequests requests_;
 
     public:
 
-        explicit FileHandler(const std::string& file_path) : file_path_(file_path) {}
+        explicit FileHandler(const std::string& file_path, FileBufferOptions options = {},
+                             RotationOptions rotation = {})
+            : writer_(file_path, rotation, options) {}
 
-        void handle(LogLevel /*level*/, const std::string& text) override 
+        void handle(LogLevel level, const std::string& text) override 
         {
-            std::ofstream file(file_path_, std::ios::app);
-            if (file) 
-            {
-                file << text << '\n';
-            }
+            requests_.apply(writer_);
+            writer_.write(level, {}, text);
+        }
+
+        void flush() override
+        {
+            requests_.apply(writer_);
+            writer_.flush();
         }
+
+        bool io_stats(HandlerIoStats& stats) const override { return writer_.io_stats(stats); }
+
+        // Переоткрыть файл по тому же пути — после того как его переименовала внешняя ротация.
+        // Безопасно из любого потока; выполняется со следующей записью или Logger::flush()
+        void reopen() { requests_.reopen(); }
+
+        // Начать новый сегмент; так же, со следующей записью или Logger::flush()
+        void rotate() { requests_.rotate(); }
+};
+ 
+// Запись в кольцевой файл, отображённый в память: для самых нагруженных компонентов.
+// Хранит последние capacity байт лога, переживает падение процесса; прочитать — MappedRingFile::read()
+class MappedRingHandler : public ILogHandler 
+{
+    private: 
+
+        MappedRingFile ring_;
+
+    public:
+
+        explicit MappedRingHandler(const std::string& file_path, std::size_t capacity = 16 * 1024 * 1024)
+            : ring_(file_path, capacity) {}
+
+        void handle(LogLevel level, const std::string& text) override 
+        {
+            ring_.write(level, text);
+        }
+
+        void flush() override { ring_.flush(); }
 };
  
 // Имитация записи в системные логи
@@ -44,49 +181,65 @@ class SyslogHandler : public ILogHandler
 {
     private: 
 
-        std::string log_file_;
+        RotatingFileWriter writer_;
+        RotationRequests requests_;
+
+        static std::string make_log_path(const std::string& log_dir, const std::string& app_name)
+        {
+            std::filesystem::create_directories(log_dir); // создаём папку
+            return log_dir + "/" + app_name + ".log";
+        }
 
     public:
 
         SyslogHandler(const std::string& log_dir = "/var/log/myapp", 
-                    const std::string& app_name = "app") 
+                    const std::string& app_name = "app",
+                    FileBufferOptions options = {},
+                    RotationOptions rotation = {}) 
+            : writer_(make_log_path(log_dir, app_name), rotation, options)
+        {}
+
+        void handle(LogLevel level, const std::string& text) override 
         {
-            std::filesystem::create_directories(log_dir); // создаём папку
-            log_file_ = log_dir + "/" + app_name + ".log";
+            requests_.apply(writer_);
+            writer_.write(level, {}, text);
         }
 
-        void handle(LogLevel /*level*/, const std::string& text) override 
+        void flush() override
         {
-            std::ofstream file(log_file_, std::ios::app);
-            if (file) 
-            {
-                file << text << '\n';;
-            }
+            requests_.apply(writer_);
+            writer_.flush();
         }
+
+        bool io_stats(HandlerIoStats& stats) const override { return writer_.io_stats(stats); }
+
+        // Как у FileHandler: выполняются со следующей записью или Logger::flush()
+        void reopen() { requests_.reopen(); }
+        void rotate() { requests_.rotate(); }
 };
 
-// Имитация: пишет в локальный файл вместо сокета
+// Отправка сборщику по TCP или UDP, по строке на запись. Не блокирует логгер:
+// пока сборщик недоступен, записи копятся в socket_<host>_<port>.spill и уходят после переподключения
 class SocketHandler : public ILogHandler 
 {
     private: 
 
-        std::string log_file_;
+        SocketSender sender_;
 
     public:
 
-        SocketHandler(const std::string& host, int port) 
-        {
-            log_file_ = "socket_" + host + "_" + std::to_string(port) + ".log";
-        }
+        SocketHandler(const std::string& host, int port, SocketOptions options = {}) 
+            : sender_(host, port, std::move(options))
+        {}
 
         void handle(LogLevel /*level*/, const std::string& text) override 
         {
-            std::ofstream file(log_file_, std::ios::app);
-            if (file) 
-            {
-                file << "[SOCKET MOCK] " << text << '\n';
-            }
+            sender_.push({}, text);
         }
+
+        void flush() override { sender_.flush(); }
+
+        std::uint64_t dropped_count() const { return sender_.dropped_count(); }
 };
  
 // Имитация: сохраняет локально, как "загруженный файл"
@@ -94,21 +247,21 @@ class FtpHandler : public ILogHandler
 {
     private: 
 
-        std::string log_file_;
+        BufferedFileWriter writer_;
 
     public:
 
-        FtpHandler(const std::string& host, const std::string& /*user*/, const std::string& /*pass*/) 
-        {
-            log_file_ = "ftp_" + host + "_log.txt";
-        }
+        FtpHandler(const std::string& host, const std::string& /*user*/, const std::string& /*pass*/,
+                   FileBufferOptions options = {}) 
+            : writer_("ftp_" + host + "_log.txt", options)
+        {}
 
-        void handle(LogLevel /*level*/, const std::string& text) override 
+        void handle(LogLevel level, const std::string& text) override 
         {
-            std::ofstream file(log_file_, std::ios::app);
-            if (file) 
-            {
-                file << "[FTP MOCK] " << text << '\n';
-            }
+            writer_.write(level, "[FTP MOCK] ", text);
         }
+
+        void flush() override { writer_.flush(); }
+
+        bool io_stats(HandlerIoStats& stats) const override { return writer_.io_stats(stats); }
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Быстрый некриптографический хеш для таблиц фильтров: по 8 байт за шаг
+// и финальное перемешивание из MurmurHash3, чтобы младшие биты годились как индекс
+namespace loghash
+{
+    inline std::uint64_t mix(std::uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    inline std::uint64_t hash(std::string_view text, std::uint64_t seed = 0)
+    {
+        constexpr std::uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+        std::uint64_t h = seed ^ (text.size() * kMul);
+        const char* p = text.data();
+        std::size_t left = text.size();
+
+        while (left >= 8)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, p, 8);
+            h = (h ^ mix(word)) * kMul;
+            h = (h << 29) | (h >> 35);
+            p += 8;
+            left -= 8;
+        }
+
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, p, left);
+        h ^= mix(tail ^ left);
+        return mix(h);
+    }
+}
\ No newline at end of file
@@ -1,6 +1,46 @@
 #pragma once
+
+#include <cstdint>
   
 enum class LogLevel
 {
-    INFO, WARN, ERROR
-};
\ No newline at end of file
+    TRACE, DEBUG, INFO, WARN, ERROR, FATAL
+};
+
+inline const char* to_string(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO";
+        case LogLevel::WARN:  return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::FATAL: return "FATAL";
+    }
+    return "";
+}
+
+// Набор уровней — по биту на уровень
+using LevelMask = std::uint32_t;
+
+constexpr LevelMask level_bit(LogLevel level)
+{
+    return LevelMask{1} << static_cast<unsigned>(level);
+}
+
+constexpr LevelMask kAllLevels = (level_bit(LogLevel::FATAL) << 1) - 1;
+
+// Уровень level и все, что серьёзнее
+constexpr LevelMask levels_from(LogLevel level)
+{
+    return kAllLevels & ~(level_bit(level) - 1);
+}
+
+// Уровни ниже этого вырезаются при компиляции: log_info и LOG_INFO превращаются в пустой код.
+// Задаётся именем уровня при сборке, например -DLOG_MIN_LEVEL=WARN
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL TRACE
+#endif
+
+constexpr LogLevel kCompiledMinLevel = LogLevel::LOG_MIN_LEVEL;
\ No newline at end of file
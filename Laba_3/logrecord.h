@@ -0,0 +1,217 @@
+#pragma once
+
+#include "loglevel.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Запись лога, хранящая текст в себе: типичное сообщение помещается во встроенный буфер,
+// длинное — в буфер в куче, который остаётся у записи и переиспользуется в следующий раз.
+// Записи не создаются и не удаляются, а берутся из RecordPool и возвращаются туда
+class LogRecord
+{
+    private:
+
+        friend class RecordPool;
+        friend class RecordRef;
+
+        static constexpr std::size_t kMaxKeptHeap = 64 * 1024; // больший буфер при возврате в пул освобождается
+
+        LogRecord* next_ = nullptr;             // звено списка свободных записей
+        std::atomic<std::uint32_t> refs_{0};
+        std::uint32_t size_ = 0;
+        std::size_t heap_capacity_ = 0;
+        std::unique_ptr<char[]> heap_;
+
+    public:
+
+        static constexpr std::size_t kInline = 216; // вместе с полями выше запись занимает 256 байт
+
+        LogLevel level = LogLevel::INFO;
+
+    private:
+
+        char inline_[kInline];
+
+    public:
+
+        void assign(std::string_view text)
+        {
+            char* target = inline_;
+            if (text.size() > kInline)
+            {
+                if (heap_capacity_ < text.size())
+                {
+                    heap_.reset(new char[text.size()]);
+                    heap_capacity_ = text.size();
+                }
+                target = heap_.get();
+            }
+            std::memcpy(target, text.data(), text.size());
+            size_ = static_cast<std::uint32_t>(text.size());
+        }
+
+        std::string_view text() const
+        {
+            return { size_ <= kInline ? inline_ : heap_.get(), size_ };
+        }
+};
+
+// Пул записей: список свободных у каждого потока и общий список под замком.
+// Поток берёт и возвращает записи в свой список без синхронизации; когда записи текут
+// между потоками (пишет один, освобождает фоновый), излишек уходит в общий список пачками
+// по kBatch, и оттуда же пачкой забирается, когда свой список пуст. Выделение памяти
+// остаётся только на разогреве
+class RecordPool
+{
+    private:
+
+        static constexpr std::size_t kBatch = 64;
+        static constexpr std::size_t kLocalMax = 4 * kBatch;
+
+        struct List
+        {
+            LogRecord* head = nullptr;
+            std::size_t count = 0;
+
+            void push(LogRecord* record)
+            {
+                record->next_ = head;
+                head = record;
+                ++count;
+            }
+
+            LogRecord* pop()
+            {
+                LogRecord* record = head;
+                head = record->next_;
+                --count;
+                return record;
+            }
+        };
+
+        struct Central
+        {
+            std::mutex mutex;
+            List free;
+        };
+
+        // При завершении потока его записи отходят в общий список
+        struct Local
+        {
+            List free;
+
+            ~Local()
+            {
+                Central& shared = central();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                while (free.head) shared.free.push(free.pop());
+            }
+        };
+
+        // Общий список не разрушается никогда: потоки, пережившие статические объекты
+        // (например, рабочий поток глобального Logger), сдают в него записи из ~Local.
+        // Оставшиеся записи освобождает ОС при выходе процесса
+        static Central& central()
+        {
+            static Central* instance = new Central;
+            return *instance;
+        }
+
+        static Local& local()
+        {
+            thread_local Local instance;
+            return instance;
+        }
+
+    public:
+
+        static LogRecord* acquire()
+        {
+            Local& own = local();
+            if (!own.free.head)
+            {
+                Central& shared = central();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                for (std::size_t i = 0; i < kBatch && shared.free.head; ++i) own.free.push(shared.free.pop());
+            }
+            return own.free.head ? own.free.pop() : new LogRecord();
+        }
+
+        static void release(LogRecord* record)
+        {
+            if (record->heap_capacity_ > LogRecord::kMaxKeptHeap)
+            {
+                record->heap_.reset();
+                record->heap_capacity_ = 0;
+            }
+
+            Local& own = local();
+            own.free.push(record);
+            if (own.free.count > kLocalMax)
+            {
+                Central& shared = central();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                for (std::size_t i = 0; i < kBatch; ++i) shared.free.push(own.free.pop());
+            }
+        }
+};
+
+// Ссылка на запись из пула со счётчиком ссылок: одну запись могут держать
+// несколько очередей сразу. Последняя ссылка возвращает запись в пул
+class RecordRef
+{
+    private:
+
+        LogRecord* record_ = nullptr;
+
+    public:
+
+        RecordRef() = default;
+
+        static RecordRef make(LogLevel level, std::string_view text)
+        {
+            RecordRef ref;
+            ref.record_ = RecordPool::acquire();
+            ref.record_->level = level;
+            ref.record_->assign(text);
+            ref.record_->refs_.store(1, std::memory_order_relaxed);
+            return ref;
+        }
+
+        RecordRef(const RecordRef& other) : record_(other.record_)
+        {
+            if (record_) record_->refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        RecordRef(RecordRef&& other) noexcept : record_(other.record_)
+        {
+            other.record_ = nullptr;
+        }
+
+        RecordRef& operator=(RecordRef other) noexcept
+        {
+            std::swap(record_, other.record_);
+            return *this;
+        }
+
+        ~RecordRef() { reset(); }
+
+        void reset()
+        {
+            if (record_ && record_->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                RecordPool::release(record_);
+            }
+            record_ = nullptr;
+        }
+
+        const LogRecord* operator->() const { return record_; }
+        const LogRecord& operator*() const { return *record_; }
+        explicit operator bool() const { return record_ != nullptr; }
+};
\ No newline at end of file
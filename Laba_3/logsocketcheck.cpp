@@ -0,0 +1,274 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "loghandlers.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Проверка SocketHandler против сборщика на 127.0.0.1 в этом же процессе: TCP и UDP,
+// обрыв и восстановление связи, досылка из spill после перезапуска. Запускается из ctest
+
+using namespace std::chrono_literals;
+
+static int g_failures = 0;
+
+static void expect(bool condition, const char* what, const std::string& detail)
+{
+    if (condition) return;
+    ++g_failures;
+    std::printf("FAIL %s: %s\n", what, detail.c_str());
+}
+
+static bool wait_for(const std::function<bool()>& done, std::chrono::milliseconds timeout = 5000ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!done())
+    {
+        if (std::chrono::steady_clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(5ms);
+    }
+    return true;
+}
+
+// Сборщик, как logcollector, но копит принятое в памяти. Порт 0 — выбрать свободный
+class Listener
+{
+    private:
+
+        SocketProtocol protocol_;
+        int port_ = 0;
+        int fd_ = -1;
+        std::atomic<bool> stop_{false};
+        std::mutex mutex_;
+        std::string received_;
+        std::thread worker_;
+
+        void append(const char* data, ssize_t size)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            received_.append(data, static_cast<std::size_t>(size));
+        }
+
+        // Ждёт данных не дольше 50 мс, чтобы вовремя заметить stop_
+        static bool readable(int fd)
+        {
+            pollfd entry{ fd, POLLIN, 0 };
+            return ::poll(&entry, 1, 50) > 0;
+        }
+
+        void run()
+        {
+            std::vector<char> buffer(65536);
+            while (!stop_.load())
+            {
+                if (!readable(fd_)) continue;
+                if (protocol_ == SocketProtocol::Udp)
+                {
+                    ssize_t size = ::recv(fd_, buffer.data(), buffer.size(), 0);
+                    if (size > 0) append(buffer.data(), size);
+                    continue;
+                }
+
+                int client = ::accept(fd_, nullptr, nullptr);
+                if (client < 0) continue;
+                while (!stop_.load())
+                {
+                    if (!readable(client)) continue;
+                    ssize_t size = ::read(client, buffer.data(), buffer.size());
+                    if (size <= 0) break;
+                    append(buffer.data(), size);
+                }
+                ::close(client);
+            }
+        }
+
+    public:
+
+        Listener(SocketProtocol protocol, int port = 0) : protocol_(protocol)
+        {
+            fd_ = ::socket(AF_INET, protocol == SocketProtocol::Udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+            int on = 1;
+            setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<std::uint16_t>(port));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            socklen_t length = sizeof(address);
+            if (::bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+                || (protocol == SocketProtocol::Tcp && ::listen(fd_, 16) != 0)
+                || ::getsockname(fd_, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+            {
+                std::perror("listener");
+                return;
+            }
+            port_ = ntohs(address.sin_port);
+            worker_ = std::thread([this] { run(); });
+        }
+
+        Listener(const Listener&) = delete;
+        Listener& operator=(const Listener&) = delete;
+
+        // Закрывает и порт, и принятое соединение: для логгера сборщик пропадает
+        ~Listener()
+        {
+            stop_.store(true);
+            if (worker_.joinable()) worker_.join();
+            if (fd_ >= 0) ::close(fd_);
+        }
+
+        int port() const { return port_; }
+
+        std::vector<std::string> lines()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::vector<std::string> result;
+            std::size_t start = 0;
+            for (std::size_t end; (end = received_.find('\n', start)) != std::string::npos; start = end + 1)
+            {
+                result.push_back(received_.substr(start, end - start));
+            }
+            return result;
+        }
+};
+
+static SocketOptions test_options(SocketProtocol protocol, const std::string& spill_path)
+{
+    SocketOptions options;
+    options.protocol = protocol;
+    options.spill_path = spill_path;
+    options.min_backoff = 10ms;
+    options.max_backoff = 100ms;
+    return options;
+}
+
+static std::string spill_file(const char* name)
+{
+    std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::filesystem::remove(path);
+    return path;
+}
+
+static std::uint64_t file_size(const std::string& path)
+{
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    return error ? 0 : static_cast<std::uint64_t>(size);
+}
+
+// Сборщик получил ровно expected, в том же порядке
+static void expect_lines(Listener& listener, const std::vector<std::string>& expected, const char* what)
+{
+    wait_for([&] { return listener.lines().size() >= expected.size(); });
+    std::vector<std::string> received = listener.lines();
+    expect(received.size() == expected.size(), what,
+           "received " + std::to_string(received.size()) + " of " + std::to_string(expected.size()) + " lines");
+    for (std::size_t i = 0; i < std::min(received.size(), expected.size()); ++i)
+    {
+        if (received[i] == expected[i]) continue;
+        expect(false, what, "line " + std::to_string(i) + ": '" + received[i] + "' != '" + expected[i] + "'");
+        break;
+    }
+}
+
+static void log_lines(SocketHandler& handler, const std::string& tag, int count, std::vector<std::string>& expected)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        std::string line = tag + " " + std::to_string(i);
+        handler.handle(LogLevel::INFO, line);
+        expected.push_back(line);
+    }
+    handler.flush();
+}
+
+static void check_delivery(SocketProtocol protocol, const char* what)
+{
+    std::string spill = spill_file("logsocketcheck_delivery.spill");
+    Listener listener(protocol);
+    std::vector<std::string> expected;
+    {
+        SocketHandler handler("127.0.0.1", listener.port(), test_options(protocol, spill));
+        log_lines(handler, "line", 500, expected);
+        expect_lines(listener, expected, what);
+        expect(handler.dropped_count() == 0, what, std::to_string(handler.dropped_count()) + " dropped");
+    }
+    expect(file_size(spill) == 0, what, "spill not empty after delivery");
+    std::filesystem::remove(spill);
+}
+
+// Сборщик пропал и вернулся на тот же порт: записанное без него приходит из spill, по порядку
+static void check_reconnect()
+{
+    std::string spill = spill_file("logsocketcheck_reconnect.spill");
+    auto listener = std::make_unique<Listener>(SocketProtocol::Tcp);
+    int port = listener->port();
+    std::vector<std::string> expected;
+
+    SocketHandler handler("127.0.0.1", port, test_options(SocketProtocol::Tcp, spill));
+    log_lines(handler, "before", 100, expected);
+    expect_lines(*listener, expected, "tcp before disconnect");
+
+    // Что ушло в сокет до того, как отправитель заметил обрыв, TCP мог потерять — ждём, пока заметит
+    listener.reset();
+    std::this_thread::sleep_for(200ms);
+
+    expected.clear();
+    log_lines(handler, "during", 100, expected);
+    expect(wait_for([&] { return file_size(spill) > 0; }), "tcp reconnect", "nothing spilled while disconnected");
+
+    listener = std::make_unique<Listener>(SocketProtocol::Tcp, port);
+    log_lines(handler, "after", 100, expected);
+    expect_lines(*listener, expected, "tcp reconnect");
+    expect(wait_for([&] { return file_size(spill) == 0; }), "tcp reconnect", "spill not emptied after replay");
+    expect(handler.dropped_count() == 0, "tcp reconnect", std::to_string(handler.dropped_count()) + " dropped");
+    std::filesystem::remove(spill);
+}
+
+// Отправитель закрылся без сборщика: строки остались в spill и ушли первыми при следующем запуске
+static void check_spill_replay()
+{
+    std::string spill = spill_file("logsocketcheck_replay.spill");
+    int port = 0;
+    {
+        Listener probe(SocketProtocol::Tcp); // только чтобы узнать свободный порт
+        port = probe.port();
+    }
+
+    std::vector<std::string> expected;
+    {
+        SocketHandler handler("127.0.0.1", port, test_options(SocketProtocol::Tcp, spill));
+        log_lines(handler, "saved", 50, expected);
+    }
+    expect(file_size(spill) > 0, "spill replay", "nothing spilled by a sender without a collector");
+
+    Listener listener(SocketProtocol::Tcp, port);
+    {
+        SocketHandler handler("127.0.0.1", port, test_options(SocketProtocol::Tcp, spill));
+        log_lines(handler, "fresh", 50, expected);
+        expect_lines(listener, expected, "spill replay");
+    }
+    expect(file_size(spill) == 0, "spill replay", "spill not emptied after replay");
+    std::filesystem::remove(spill);
+}
+
+int main()
+{
+    check_delivery(SocketProtocol::Tcp, "tcp delivery");
+    check_delivery(SocketProtocol::Udp, "udp delivery");
+    check_reconnect();
+    check_spill_replay();
+
+    if (g_failures) std::printf("%d check(s) failed\n", g_failures);
+    else std::printf("all checks passed\n");
+    return g_failures ? 1 : 0;
+}
\ No newline at end of file
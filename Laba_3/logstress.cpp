@@ -0,0 +1,148 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "loghandlers.h"
+#include "simpleformatter.h"
+
+// Нагрузочная проверка потокобезопасности Logger; CMake собирает её с -fsanitize=thread.
+// Несколько потоков пишут в логгер каждого режима, пока ещё один поток крутит rotate(),
+// reopen() и flush(). Проверяется, что ни одна запись не потеряна и не испорчена
+// и что записи каждого потока пришли в том порядке, в каком были сделаны
+
+static const std::size_t kProducers = 8;
+static const std::size_t kRecordsPerProducer = 5000;
+
+// Разбирает строки "T<поток> <номер>" и следит за порядком внутри потока.
+// Logger вызывает handle() под замком обработчика, так что своих замков не нужно
+class OrderChecker : public ILogHandler
+{
+    private:
+
+        std::vector<long> last_;
+        std::size_t records_ = 0;
+        std::size_t errors_ = 0;
+
+    public:
+
+        OrderChecker() : last_(kProducers, -1) {}
+
+        void handle(LogLevel /*level*/, const std::string& text) override
+        {
+            ++records_;
+            unsigned long thread = 0;
+            long sequence = 0;
+            if (std::sscanf(text.c_str(), "T%lu %ld", &thread, &sequence) != 2 || thread >= kProducers
+                || sequence != last_[thread] + 1)
+            {
+                ++errors_;
+                return;
+            }
+            last_[thread] = sequence;
+        }
+
+        std::size_t records() const { return records_; }
+        std::size_t errors() const { return errors_; }
+};
+
+struct Mode
+{
+    const char* name;
+    bool async;
+    bool fanout;
+};
+
+static bool run_mode(const Mode& mode, const std::string& directory)
+{
+    const std::string path = directory + "/stress_" + mode.name + ".log";
+
+    auto checker_owner = std::make_unique<OrderChecker>();
+    auto file_owner = std::make_unique<FileHandler>(path, FileBufferOptions{}, RotationOptions{});
+    OrderChecker* checker = checker_owner.get();
+    FileHandler* file = file_owner.get();
+
+    std::vector<std::unique_ptr<ILogFormatter>> stamped;
+    stamped.push_back(std::make_unique<SimpleFormatter>());
+    std::vector<HandlerSpec> handlers;
+    handlers.emplace_back(std::move(checker_owner));
+    handlers.emplace_back(std::move(file_owner), kAllLevels, std::make_shared<const FormatterChain>(std::move(stamped)));
+
+    // Очереди блокируют, а не выбрасывают: проверка считает каждую запись
+    AsyncOptions async{256, OverflowPolicy::Block, ClockOptions{}};
+    FanOutOptions fanout{2, 256, OverflowPolicy::Block};
+    std::unique_ptr<Logger> logger;
+    if (mode.async && mode.fanout) logger = std::make_unique<Logger>(
+        std::vector<std::unique_ptr<ILogFilter>>{}, std::vector<std::unique_ptr<ILogFormatter>>{}, std::move(handlers), async, fanout);
+    else if (mode.async) logger = std::make_unique<Logger>(
+        std::vector<std::unique_ptr<ILogFilter>>{}, std::vector<std::unique_ptr<ILogFormatter>>{}, std::move(handlers), async);
+    else if (mode.fanout) logger = std::make_unique<Logger>(
+        std::vector<std::unique_ptr<ILogFilter>>{}, std::vector<std::unique_ptr<ILogFormatter>>{}, std::move(handlers), fanout);
+    else logger = std::make_unique<Logger>(
+        std::vector<std::unique_ptr<ILogFilter>>{}, std::vector<std::unique_ptr<ILogFormatter>>{}, std::move(handlers));
+
+    std::atomic<bool> producing{true};
+    std::thread admin([&]()
+    {
+        while (producing.load(std::memory_order_acquire))
+        {
+            file->rotate();
+            logger->flush();
+            file->reopen();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (std::size_t t = 0; t < kProducers; ++t)
+    {
+        producers.emplace_back([&, t]()
+        {
+            for (std::size_t i = 0; i < kRecordsPerProducer; ++i) logger->log(LogLevel::INFO, "T{} {}", t, i);
+        });
+    }
+    for (auto& producer : producers) producer.join();
+    producing.store(false, std::memory_order_release);
+    admin.join();
+    logger->flush();
+
+    std::size_t lines = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        if (entry.path().filename().string().rfind("stress_" + std::string(mode.name) + ".log", 0) != 0) continue;
+        std::FILE* in = std::fopen(entry.path().c_str(), "r");
+        if (!in) continue;
+        for (int c; (c = std::fgetc(in)) != EOF;) lines += c == '\n';
+        std::fclose(in);
+    }
+
+    const std::size_t expected = kProducers * kRecordsPerProducer;
+    bool ok = checker->records() == expected && checker->errors() == 0 && lines == expected;
+    std::printf("%-14s records=%zu out_of_order=%zu file_lines=%zu %s\n", mode.name, checker->records(),
+                checker->errors(), lines, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main()
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "logstress";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const Mode modes[] = {
+        { "sync", false, false },
+        { "async", true, false },
+        { "fanout", false, true },
+        { "async_fanout", true, true },
+    };
+    bool ok = true;
+    for (const Mode& mode : modes) ok = run_mode(mode, directory.string()) && ok;
+
+    std::filesystem::remove_all(directory);
+    return ok ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "loglevel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Кольцевой журнал в отображённом в память файле. Запись — это memcpy в общую память,
+// системных вызовов нет; после падения процесса в файле остаются последние записи,
+// и их можно восстановить по порядку с помощью read().
+//
+// Первая страница — заголовок, дальше кольцо данных. Каждая запись выровнена на 8 байт:
+//   u32 'LOGR' u32 длина u64 номер u32 контрольная_сумма u8 уровень 3 байта пусто, затем текст.
+// Запись, часть которой затёрта новыми данными или не дописана при падении,
+// не сходится по контрольной сумме и при чтении отбрасывается. Целые, но старые записи
+// прошлых кругов отсекает номер: читаются только записи подряд до последнего номера
+class MappedRingFile
+{
+    private:
+
+        static constexpr std::uint64_t kFileMagic = 0x31474E49524F4C4Cull;  // "LLORING1"
+        static constexpr std::uint32_t kRecordMagic = 0x52474F4Cu;          // "LOGR"
+        static constexpr std::size_t kHeaderSize = 4096;
+        static constexpr std::size_t kRecordHeaderSize = 24;
+
+        struct FileHeader
+        {
+            std::uint64_t magic;
+            std::uint64_t capacity;      // размер кольца данных
+            std::uint64_t write_offset;  // логическое смещение, только растёт
+            std::uint64_t next_sequence;
+        };
+
+        struct RecordHeader
+        {
+            std::uint32_t magic;
+            std::uint32_t length;
+            std::uint64_t sequence;
+            std::uint32_t checksum;
+            std::uint8_t level;
+            std::uint8_t reserved[3];
+        };
+        static_assert(sizeof(RecordHeader) == kRecordHeaderSize, "record header layout");
+
+        int fd_ = -1;
+        char* base_ = nullptr;
+        std::size_t mapped_size_ = 0;
+        FileHeader* header_ = nullptr;
+        char* data_ = nullptr;
+
+        static std::size_t align8(std::size_t size) { return (size + 7) & ~std::size_t{7}; }
+
+        // FNV-1a по номеру, уровню, длине и тексту
+        static std::uint32_t checksum(std::uint64_t sequence, std::uint8_t level, std::string_view text)
+        {
+            std::uint32_t hash = 2166136261u;
+            auto mix = [&hash](const void* data, std::size_t size)
+            {
+                const auto* bytes = static_cast<const unsigned char*>(data);
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    hash ^= bytes[i];
+                    hash *= 16777619u;
+                }
+            };
+            auto length = static_cast<std::uint32_t>(text.size());
+            mix(&sequence, sizeof(sequence));
+            mix(&level, sizeof(level));
+            mix(&length, sizeof(length));
+            mix(text.data(), text.size());
+            return hash;
+        }
+
+        // Запись по смещению pos кольца, если она цела; size — сколько места она занимает
+        static bool parse_record(const char* data, std::size_t capacity, std::size_t pos,
+                                 RecordHeader& header, std::string_view& text, std::size_t& size)
+        {
+            if (capacity - pos < kRecordHeaderSize) return false;
+            std::memcpy(&header, data + pos, sizeof(header));
+            if (header.magic != kRecordMagic) return false;
+            if (header.length > capacity - pos - kRecordHeaderSize) return false;
+
+            text = std::string_view(data + pos + kRecordHeaderSize, header.length);
+            if (checksum(header.sequence, header.level, text) != header.checksum) return false;
+
+            size = align8(kRecordHeaderSize + header.length);
+            return true;
+        }
+
+        void unmap()
+        {
+            if (base_) munmap(base_, mapped_size_);
+            if (fd_ >= 0) ::close(fd_);
+            base_ = nullptr;
+            fd_ = -1;
+        }
+
+    public:
+
+        struct Record
+        {
+            std::uint64_t sequence = 0;
+            LogLevel level = LogLevel::INFO;
+            std::string text;
+        };
+
+        // Открывает существующее кольцо того же размера и продолжает его, иначе создаёт заново
+        MappedRingFile(const std::string& path, std::size_t capacity)
+        {
+            capacity = std::max(align8(capacity), std::size_t{4096});
+            mapped_size_ = kHeaderSize + capacity;
+
+            fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (fd_ < 0) return;
+
+            struct stat info{};
+            bool reuse = fstat(fd_, &info) == 0 && static_cast<std::size_t>(info.st_size) == mapped_size_;
+            if (!reuse && ftruncate(fd_, static_cast<off_t>(mapped_size_)) != 0)
+            {
+                unmap();
+                return;
+            }
+
+            void* mapped = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if (mapped == MAP_FAILED)
+            {
+                base_ = nullptr;
+                unmap();
+                return;
+            }
+            base_ = static_cast<char*>(mapped);
+            header_ = reinterpret_cast<FileHeader*>(base_);
+            data_ = base_ + kHeaderSize;
+
+            if (!reuse || header_->magic != kFileMagic || header_->capacity != capacity)
+            {
+                std::memset(base_, 0, mapped_size_);
+                header_->capacity = capacity;
+                header_->write_offset = 0;
+                header_->next_sequence = 0;
+                header_->magic = kFileMagic;
+            }
+        }
+
+        MappedRingFile(const MappedRingFile&) = delete;
+        MappedRingFile& operator=(const MappedRingFile&) = delete;
+
+        ~MappedRingFile() { unmap(); }
+
+        bool is_open() const { return base_ != nullptr; }
+
+        // Не потокобезопасен: Logger вызывает обработчик под его собственным замком.
+        // Слишком длинный текст обрезается до четверти кольца
+        void write(LogLevel level, std::string_view text)
+        {
+            if (!base_) return;
+
+            const std::size_t capacity = header_->capacity;
+            text = text.substr(0, capacity / 4);
+            const std::size_t size = align8(kRecordHeaderSize + text.size());
+
+            std::uint64_t offset = header_->write_offset;
+            std::size_t pos = static_cast<std::size_t>(offset % capacity);
+            if (capacity - pos < size)
+            {
+                // Хвост кольца пропускаем, запись начнётся с нуля. Старые записи в хвосте
+                // стираются, иначе read() нашёл бы их и через несколько кругов
+                std::memset(data_ + pos, 0, capacity - pos);
+                offset += capacity - pos;
+                pos = 0;
+            }
+
+            RecordHeader record{};
+            record.magic = kRecordMagic;
+            record.length = static_cast<std::uint32_t>(text.size());
+            record.sequence = header_->next_sequence;
+            record.level = static_cast<std::uint8_t>(level);
+            record.checksum = checksum(record.sequence, record.level, text);
+
+            // Сначала текст, потом заголовок: оборванная на середине запись не пройдёт проверку
+            std::memcpy(data_ + pos + kRecordHeaderSize, text.data(), text.size());
+            std::memcpy(data_ + pos, &record, sizeof(record));
+
+            header_->next_sequence = record.sequence + 1;
+            header_->write_offset = offset + size;
+        }
+
+        // Просит ядро начать запись страниц на диск; для переживания падения процесса не нужно
+        void flush()
+        {
+            if (base_) msync(base_, mapped_size_, MS_ASYNC);
+        }
+
+        // Оставляет непрерывный ряд номеров, которым кончается журнал. Последний номер —
+        // next_sequence - 1 либо next_sequence, если процесс упал, дописав запись, но не счётчик
+        static void keep_last_run(std::vector<Record>& records, std::uint64_t next_sequence)
+        {
+            std::sort(records.begin(), records.end(),
+                [](const Record& a, const Record& b) { return a.sequence < b.sequence; });
+
+            auto end = std::upper_bound(records.begin(), records.end(), next_sequence,
+                [](std::uint64_t sequence, const Record& record) { return sequence < record.sequence; });
+            if (end == records.begin() || std::prev(end)->sequence + 1 < next_sequence)
+            {
+                records.clear();
+                return;
+            }
+
+            auto first = std::prev(end);
+            while (first != records.begin() && std::prev(first)->sequence + 1 == first->sequence) --first;
+            records.erase(end, records.end());
+            records.erase(records.begin(), first);
+        }
+
+        // Целые записи кольца в порядке номеров
+        static std::vector<Record> read(const std::string& path)
+        {
+            std::vector<Record> records;
+
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return records;
+
+            struct stat info{};
+            if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) <= kHeaderSize)
+            {
+                ::close(fd);
+                return records;
+            }
+
+            auto size = static_cast<std::size_t>(info.st_size);
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (mapped == MAP_FAILED) return records;
+
+            const char* base = static_cast<const char*>(mapped);
+            FileHeader header{};
+            std::memcpy(&header, base, sizeof(header));
+            if (header.magic == kFileMagic && header.capacity == size - kHeaderSize)
+            {
+                const char* data = base + kHeaderSize;
+                const std::size_t capacity = static_cast<std::size_t>(header.capacity);
+
+                // Записи выровнены на 8 байт: идём по кольцу, перепрыгивая через целые
+                // записи и по 8 байт через испорченные места
+                std::size_t pos = 0;
+                while (pos < capacity)
+                {
+                    RecordHeader record{};
+                    std::string_view text;
+                    std::size_t record_size = 0;
+                    if (parse_record(data, capacity, pos, record, text, record_size))
+                    {
+                        records.push_back({ record.sequence, static_cast<LogLevel>(record.level), std::string(text) });
+                        pos += record_size;
+                    }
+                    else
+                    {
+                        pos += 8;
+                    }
+                }
+                keep_last_run(records, header.next_sequence);
+            }
+            munmap(mapped, size);
+            return records;
+        }
+};
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "logger.h"
+#include "iloghandler.h"
+#include "logformat.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Раз в interval снимает metrics() логгера и отдаёт строкой своему обработчику.
+// Обработчик отдельный, а не один из обработчиков логгера: метрики не проходят через
+// фильтры и не попадают в собственные счётчики. Логгер должен жить дольше репортёра
+class MetricsReporter
+{
+    private:
+
+        const Logger& logger_;
+        std::unique_ptr<ILogHandler> handler_;
+        std::chrono::milliseconds interval_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stop_ = false;
+        std::thread worker_;
+
+        // Под mutex_: обработчик не обязан быть потокобезопасным
+        void report()
+        {
+            handler_->handle(LogLevel::INFO, format(logger_.metrics()));
+            handler_->flush();
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!wake_.wait_for(lock, interval_, [this] { return stop_; }))
+            {
+                report();
+            }
+        }
+
+    public:
+
+        MetricsReporter(const Logger& logger, std::unique_ptr<ILogHandler> handler,
+                        std::chrono::milliseconds interval = std::chrono::seconds(10))
+            : logger_(logger)
+            , handler_(std::move(handler))
+            , interval_(interval)
+            , worker_([this] { run(); })
+        {}
+
+        MetricsReporter(const MetricsReporter&) = delete;
+        MetricsReporter& operator=(const MetricsReporter&) = delete;
+
+        ~MetricsReporter()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            worker_.join();
+        }
+
+        // "logger queue=0 enqueued=10 processed=10 dropped=0 | handler#0 records=... | filter#0 accepted=..."
+        static std::string format(const LoggerMetrics& metrics)
+        {
+            std::string out = logformat::format("logger queue={} enqueued={} processed={} dropped={}",
+                metrics.queue_depth, metrics.enqueued, metrics.processed, metrics.dropped);
+            for (std::size_t i = 0; i < metrics.handlers.size(); ++i)
+            {
+                const HandlerMetrics& h = metrics.handlers[i];
+                logformat::format_to(out, " | handler#{} records={} bytes={} flushes={} flush_avg_ns={} flush_max_ns={}",
+                    i, h.records, h.bytes, h.flushes, static_cast<std::uint64_t>(h.flush_average_ns), h.flush_max_ns);
+                if (metrics.fanout)
+                {
+                    logformat::format_to(out, " queue={} lag_ns={} max_lag_ns={} dropped={}",
+                        h.queue_depth, h.lag_ns, h.max_lag_ns, h.dropped);
+                }
+            }
+            for (std::size_t i = 0; i < metrics.filters.size(); ++i)
+            {
+                const FilterStats& f = metrics.filters[i];
+                logformat::format_to(out, " | filter#{} accepted={} rejected={} avg_ns={}",
+                    i, f.accepted, f.rejected, static_cast<std::uint64_t>(f.average_ns));
+            }
+            return out;
+        }
+
+        // Внеочередной снимок — например, перед завершением программы
+        void report_now()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            report();
+        }
+};
\ No newline at end of file
@@ -35,7 +35,7 @@ int main()
     handlers.push_back(std::make_unique<ConsoleHandler>());
     // 2. Запись в файл
     handlers.push_back(std::make_unique<FileHandler>("lab3_output.log"));
-    // 3. Имитация отправки по сокету (сохранит в socket_localhost_9999.log)
+    // 3. Отправка по TCP на localhost:9999 (без сборщика копится в socket_localhost_9999.spill)
     handlers.push_back(std::make_unique<SocketHandler>("localhost", 9999));
     // 4. Имитация системного лога (сохранит в /var/log/myapp/app.log или аналог)
     handlers.push_back(std::make_unique<SyslogHandler>());
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "logger.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Раз в interval зовёт logger.flush(): буферы обработчиков синхронного логгера уходят
+// на диск, даже если новых записей нет. flush() берёт замки обработчиков, так что гонки
+// с пишущими потоками нет. Логгер должен жить дольше
+class PeriodicFlusher
+{
+    private:
+
+        Logger& logger_;
+        std::chrono::milliseconds interval_;
+
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stop_ = false;
+        std::thread worker_;
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!wake_.wait_for(lock, interval_, [this] { return stop_; }))
+            {
+                lock.unlock();
+                logger_.flush();
+                lock.lock();
+            }
+        }
+
+    public:
+
+        explicit PeriodicFlusher(Logger& logger, std::chrono::milliseconds interval = std::chrono::seconds(1))
+            : logger_(logger)
+            , interval_(interval)
+            , worker_([this] { run(); })
+        {}
+
+        PeriodicFlusher(const PeriodicFlusher&) = delete;
+        PeriodicFlusher& operator=(const PeriodicFlusher&) = delete;
+
+        ~PeriodicFlusher()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            worker_.join();
+        }
+};
\ No newline at end of file
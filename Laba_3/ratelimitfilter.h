@@ -0,0 +1,244 @@
+#pragma once
+
+#include "ilogfilter.h"
+#include "loghash.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct RateLimitOptions
+{
+    double rate = 10.0;          // записей в секунду на одно сообщение
+    double burst = 50.0;         // столько можно сразу, пока ведро полное
+    std::size_t slots = 4096;    // размер таблицы, округляется до степени двойки
+    bool collapse_repeats = true;                       // одинаковые подряд — одной строкой и сводкой
+    std::chrono::milliseconds summary_interval{5000};   // как часто сводка о повторах уходит, пока они идут
+};
+
+// Сводка об отброшенных записях: text — само сообщение, count — сколько раз отброшено
+using SuppressionCallback = std::function<void(LogLevel level, const std::string& text, std::uint64_t count)>;
+
+// Ограничивает поток одинаковых сообщений.
+// 1. Повторы: запись, которая в своём потоке идёт сразу за такой же, отбрасывается и считается.
+//    Счёт уходит в callback ("repeated N times"), когда поток пишет другое сообщение, и раз
+//    в summary_interval, пока серия идёт или после того, как она кончилась. Серию, после которой
+//    поток замолчал, отдаёт тот, кто первым пишет через этот фильтр после summary_interval.
+// 2. Ведро токенов: остальные записи — не чаще rate в секунду на сообщение, сколько бы других
+//    сообщений ни шло между ними. Когда ключ снова проходит, callback получает число отброшенных.
+// Общего замка нет: последнее сообщение хранится в ячейке потока (потоки распределены
+// по kShards ячейкам), ведро ключа — в ячейке хеш-таблицы фиксированного размера, у каждой
+// ячейки свой замок. При коллизии ячейку таблицы занимает новый ключ, и его счета теряются.
+// Callback вызывается вне замков и может писать в тот же логгер: запись, сделанная
+// из callback, проходит этот фильтр без проверки
+class RateLimitFilter : public ILogFilter
+{
+    private:
+
+        static constexpr std::size_t kShards = 64;
+
+        struct alignas(64) Slot
+        {
+            std::atomic_flag busy = ATOMIC_FLAG_INIT;
+            std::uint64_t key = 0;
+            double tokens = 0.0;
+            std::int64_t updated_ns = 0;
+            std::uint64_t suppressed = 0;
+        };
+
+        // Последнее сообщение потоков ячейки и повторы, ещё не отданные в сводку
+        struct alignas(64) Shard
+        {
+            std::atomic_flag busy = ATOMIC_FLAG_INIT;
+            std::uint64_t key = 0;
+            LogLevel level = LogLevel::INFO;
+            std::string text;               // заполняется на первом повторе
+            std::uint64_t repeats = 0;
+            std::int64_t series_ns = 0;     // первый повтор, ещё не попавший в сводку
+        };
+
+        struct Summary
+        {
+            LogLevel level;
+            std::string text;
+            std::uint64_t count;
+        };
+
+        RateLimitOptions options_;
+        SuppressionCallback on_suppressed_;
+        std::unique_ptr<Slot[]> slots_;
+        std::size_t mask_;
+        std::int64_t interval_ns_;
+        std::unique_ptr<Shard[]> shards_;
+        mutable std::atomic<std::int64_t> next_sweep_ns_;
+
+        static std::size_t round_up_pow2(std::size_t value)
+        {
+            std::size_t result = 1;
+            while (result < value) result <<= 1;
+            return result;
+        }
+
+        static std::int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Номер потока по порядку появления: соседние потоки попадают в разные ячейки
+        static std::size_t thread_shard()
+        {
+            static std::atomic<std::size_t> counter{0};
+            thread_local std::size_t number = counter.fetch_add(1, std::memory_order_relaxed);
+            return number % kShards;
+        }
+
+        static void lock(std::atomic_flag& busy) { while (busy.test_and_set(std::memory_order_acquire)) {} }
+        static void unlock(std::atomic_flag& busy) { busy.clear(std::memory_order_release); }
+
+        // true, пока поток внутри callback
+        static bool& reporting()
+        {
+            thread_local bool flag = false;
+            return flag;
+        }
+
+        void report(LogLevel level, const std::string& text, std::uint64_t count) const
+        {
+            if (!count || !on_suppressed_) return;
+            reporting() = true;
+            on_suppressed_(level, text, count);
+            reporting() = false;
+        }
+
+        // Раз в summary_interval: сводки по сериям, которые идут или кончились, пока их поток молчит.
+        // Обходит ячейки тот, кто первым заметил, что срок прошёл
+        void sweep(std::int64_t now) const
+        {
+            std::int64_t due = next_sweep_ns_.load(std::memory_order_relaxed);
+            if (now < due) return;
+            if (!next_sweep_ns_.compare_exchange_strong(due, now + interval_ns_, std::memory_order_relaxed)) return;
+
+            std::vector<Summary> summaries;
+            for (std::size_t i = 0; i < kShards; ++i)
+            {
+                Shard& shard = shards_[i];
+                lock(shard.busy);
+                if (shard.repeats > 0 && now - shard.series_ns >= interval_ns_)
+                {
+                    summaries.push_back({ shard.level, shard.text, shard.repeats });
+                    shard.repeats = 0;
+                }
+                unlock(shard.busy);
+            }
+            for (const Summary& summary : summaries) report(summary.level, summary.text, summary.count);
+        }
+
+        // Повтор последнего сообщения потока: true — запись отбрасывается. Иначе ячейка
+        // запоминает новое сообщение, а счёт прежней серии, если был, отдаётся в pending
+        bool collapse(std::uint64_t key, LogLevel level, const std::string& text, std::int64_t now, Summary& pending) const
+        {
+            Shard& shard = shards_[thread_shard()];
+            lock(shard.busy);
+
+            bool repeat = shard.key == key;
+            if (repeat)
+            {
+                if (shard.repeats++ == 0)
+                {
+                    shard.series_ns = now;
+                    shard.text = text;
+                }
+                if (now - shard.series_ns >= interval_ns_)
+                {
+                    pending = { shard.level, shard.text, shard.repeats };
+                    shard.repeats = 0;
+                }
+            }
+            else
+            {
+                if (shard.repeats > 0) pending = { shard.level, std::move(shard.text), shard.repeats };
+                shard.key = key;
+                shard.level = level;
+                shard.repeats = 0;
+            }
+
+            unlock(shard.busy);
+            return repeat;
+        }
+
+        // Ведро токенов ключа; suppressed_before — сколько отброшено с прошлого раза, если запись прошла
+        bool admit(std::uint64_t key, std::int64_t now, std::uint64_t& suppressed_before) const
+        {
+            Slot& slot = slots_[key & mask_];
+            lock(slot.busy);
+
+            if (slot.key != key)
+            {
+                slot.key = key;
+                slot.tokens = options_.burst;
+                slot.suppressed = 0;
+            }
+            else
+            {
+                double elapsed = static_cast<double>(now - slot.updated_ns) * 1e-9;
+                slot.tokens = std::min(options_.burst, slot.tokens + elapsed * options_.rate);
+            }
+            slot.updated_ns = now;
+
+            bool pass = slot.tokens >= 1.0;
+            if (pass)
+            {
+                slot.tokens -= 1.0;
+                suppressed_before = slot.suppressed;
+                slot.suppressed = 0;
+            }
+            else
+            {
+                ++slot.suppressed;
+            }
+
+            unlock(slot.busy);
+            return pass;
+        }
+
+    public:
+
+        explicit RateLimitFilter(RateLimitOptions options = {}, SuppressionCallback on_suppressed = nullptr)
+            : options_(options)
+            , on_suppressed_(std::move(on_suppressed))
+            , slots_(new Slot[round_up_pow2(options.slots)])
+            , mask_(round_up_pow2(options.slots) - 1)
+            , interval_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(options.summary_interval).count())
+            , shards_(new Shard[kShards])
+            , next_sweep_ns_(now_ns() + interval_ns_)
+        {}
+
+        bool match(LogLevel level, const std::string& text) const override
+        {
+            if (reporting()) return true; // сводка из callback
+            // 0 зарезервирован под "ключа нет"
+            std::uint64_t key = loghash::hash(text, static_cast<std::uint64_t>(level) + 1) | 1;
+            std::int64_t now = now_ns();
+
+            if (options_.collapse_repeats)
+            {
+                sweep(now);
+                Summary pending{ level, {}, 0 };
+                bool repeat = collapse(key, level, text, now, pending);
+                report(pending.level, pending.text, pending.count);
+                if (repeat) return false;
+            }
+
+            std::uint64_t suppressed = 0;
+            bool pass = admit(key, now, suppressed);
+            if (pass) report(level, text, suppressed);
+            return pass;
+        }
+
+        bool reorderable() const override { return false; }
+};
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Ограниченная lock-free очередь на кольцевом буфере (схема Вьюкова).
+// Писать могут сколько угодно потоков, читает обычно один поток-обработчик,
+// но try_pop безопасен и из нескольких потоков — это нужно политике DropOldest,
+// когда писатель сам выбрасывает самую старую запись.
+template <typename T>
+class RingBuffer
+{
+    private:
+
+        static constexpr std::size_t kCacheLine = 64;
+
+        struct Cell
+        {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        std::size_t mask_;
+
+        alignas(kCacheLine) std::atomic<std::size_t> enqueue_pos_{0};
+        alignas(kCacheLine) std::atomic<std::size_t> dequeue_pos_{0};
+
+        static std::size_t round_up_pow2(std::size_t value)
+        {
+            std::size_t result = 2;
+            while (result < value) result <<= 1;
+            return result;
+        }
+
+    public:
+
+        // Ёмкость округляется вверх до степени двойки
+        explicit RingBuffer(std::size_t capacity)
+            : cells_(new Cell[round_up_pow2(capacity)])
+            , mask_(round_up_pow2(capacity) - 1)
+        {
+            for (std::size_t i = 0; i <= mask_; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        // false — очередь заполнена, value остаётся нетронутым
+        bool try_push(T&& value)
+        {
+            std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& cell = cells_[pos & mask_];
+                std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+                if (diff == 0)
+                {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        cell.value = std::move(value);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false; // заполнена
+                }
+                else
+                {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // false — очередь пуста
+        bool try_pop(T& out)
+        {
+            std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                Cell& cell = cells_[pos & mask_];
+                std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+
+                if (diff == 0)
+                {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        out = std::move(cell.value);
+                        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false; // пуста
+                }
+                else
+                {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Приблизительный размер: под нагрузкой значение может устареть сразу после чтения
+        std::size_t size() const
+        {
+            std::size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+            std::size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+        // Сколько записей положено и забрано с создания очереди
+        std::size_t pushed() const { return enqueue_pos_.load(std::memory_order_acquire); }
+        std::size_t popped() const { return dequeue_pos_.load(std::memory_order_acquire); }
+
+        std::size_t capacity() const { return mask_ + 1; }
+};
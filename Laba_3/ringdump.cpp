@@ -0,0 +1,30 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "mappedring.h"
+
+// Печатает записи кольцевого файла MappedRingHandler в порядке записи,
+// например после падения процесса: ringdump <файл> [сколько последних]
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <ring file> [last N]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<MappedRingFile::Record> records = MappedRingFile::read(argv[1]);
+    std::size_t skip = 0;
+    if (argc > 2)
+    {
+        std::size_t last = std::strtoul(argv[2], nullptr, 10);
+        if (last < records.size()) skip = records.size() - last;
+    }
+
+    for (std::size_t i = skip; i < records.size(); ++i)
+    {
+        std::printf("%s\n", records[i].text.c_str());
+    }
+    std::fprintf(stderr, "%zu records\n", records.size() - skip);
+}
\ No newline at end of file
@@ -0,0 +1,306 @@
+#pragma once
+
+#include "filewriter.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifdef LOGGER_USE_ZLIB
+#include <zlib.h>
+#endif
+
+// Когда и как ротировать файл лога. Нули означают "без ограничения"
+struct RotationOptions
+{
+    std::uint64_t max_bytes = 0;             // ротация, когда файл дорос до этого размера
+    std::chrono::seconds interval{0};        // ротация на границах интервала по местным часам: 3600 — каждый час в :00,
+                                             // 86400 — в местную полночь
+    std::size_t max_files = 0;               // сколько старых сегментов хранить
+    std::uint64_t max_total_bytes = 0;       // сколько места могут занимать старые сегменты вместе
+    bool compress = true;                    // сжимать старые сегменты в .gz (если собрано с zlib)
+
+    bool enabled() const { return max_bytes > 0 || interval.count() > 0; }
+};
+
+// Фоновый поток, который сжимает ротированные сегменты и удаляет лишние,
+// чтобы поток, пишущий лог, не ждал ни gzip, ни обхода каталога
+class SegmentCompressor
+{
+    private:
+
+        std::string base_path_;
+        RotationOptions options_;
+        std::deque<std::string> jobs_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stop_ = false;
+        std::thread worker_;
+
+        // Сегмент сжимается во временный файл, который переименовывается только целиком:
+        // после падения не останется наполовину сжатого .gz
+        static bool compress(const std::string& path)
+        {
+#ifdef LOGGER_USE_ZLIB
+            std::FILE* in = std::fopen(path.c_str(), "rb");
+            if (!in) return false;
+
+            std::string partial = path + ".gz.part";
+            gzFile out = gzopen(partial.c_str(), "wb6");
+            if (!out)
+            {
+                std::fclose(in);
+                return false;
+            }
+
+            std::vector<char> chunk(256 * 1024);
+            bool ok = true;
+            std::size_t read = 0;
+            while (ok && (read = std::fread(chunk.data(), 1, chunk.size(), in)) > 0)
+            {
+                ok = gzwrite(out, chunk.data(), static_cast<unsigned>(read)) == static_cast<int>(read);
+            }
+            ok = gzclose(out) == Z_OK && ok && !std::ferror(in);
+            std::fclose(in);
+
+            std::error_code error;
+            if (ok) std::filesystem::rename(partial, path + ".gz", error);
+            if (!ok || error)
+            {
+                std::filesystem::remove(partial, error);
+                return false;
+            }
+            std::filesystem::remove(path, error);
+            return true;
+#else
+            (void)path;
+            return false;
+#endif
+        }
+
+        static bool all_digits(std::string_view text)
+        {
+            return std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+        }
+
+        // Имя, которое даёт RotatingFileWriter::segment_path(): "<prefix>YYYYmmdd-HHMMSS-NNNN[.gz]".
+        // Прочие файлы с тем же началом (app.log.bak, app.log.1 чужой ротации, .part) не трогаем
+        static bool is_segment_name(std::string_view name, std::string_view prefix)
+        {
+            if (name.compare(0, prefix.size(), prefix) != 0) return false;
+            std::string_view stamp = name.substr(prefix.size());
+            if (stamp.size() == 23 && stamp.compare(20, 3, ".gz") == 0) stamp = stamp.substr(0, 20);
+            return stamp.size() == 20
+                && all_digits(stamp.substr(0, 8)) && stamp[8] == '-'
+                && all_digits(stamp.substr(9, 6)) && stamp[15] == '-'
+                && all_digits(stamp.substr(16, 4));
+        }
+
+        // Старые сегменты называются "<файл>.<время>-<номер>[.gz]", так что порядок имён — порядок времени
+        void enforce_retention()
+        {
+            if (options_.max_files == 0 && options_.max_total_bytes == 0) return;
+
+            std::filesystem::path base(base_path_);
+            std::filesystem::path directory = base.has_parent_path() ? base.parent_path() : std::filesystem::path(".");
+            std::string prefix = base.filename().string() + ".";
+
+            struct Segment { std::string name; std::filesystem::path path; std::uint64_t size; };
+            std::vector<Segment> segments;
+
+            std::error_code error;
+            for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+            {
+                std::string name = entry.path().filename().string();
+                if (!is_segment_name(name, prefix)) continue;
+                segments.push_back({ name, entry.path(), static_cast<std::uint64_t>(entry.file_size(error)) });
+            }
+            std::sort(segments.begin(), segments.end(),
+                [](const Segment& a, const Segment& b) { return a.name > b.name; }); // сначала новые
+
+            std::uint64_t total = 0;
+            for (std::size_t i = 0; i < segments.size(); ++i)
+            {
+                total += segments[i].size;
+                bool too_many = options_.max_files > 0 && i >= options_.max_files;
+                bool too_big = options_.max_total_bytes > 0 && total > options_.max_total_bytes;
+                if (too_many || too_big)
+                {
+                    std::filesystem::remove(segments[i].path, error);
+                }
+            }
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;)
+            {
+                cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+                if (jobs_.empty()) return; // stop_ и делать больше нечего
+
+                std::string path = std::move(jobs_.front());
+                jobs_.pop_front();
+                lock.unlock();
+
+                if (options_.compress) compress(path);
+                enforce_retention();
+
+                lock.lock();
+            }
+        }
+
+    public:
+
+        SegmentCompressor(const std::string& base_path, RotationOptions options)
+            : base_path_(base_path)
+            , options_(options)
+            , worker_([this] { run(); })
+        {}
+
+        SegmentCompressor(const SegmentCompressor&) = delete;
+        SegmentCompressor& operator=(const SegmentCompressor&) = delete;
+
+        // Дожимает всё, что уже поставлено в очередь
+        ~SegmentCompressor()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_one();
+            worker_.join();
+        }
+
+        void submit(std::string segment_path)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                jobs_.push_back(std::move(segment_path));
+            }
+            cv_.notify_one();
+        }
+};
+
+// Буферизованный писатель с ротацией по размеру и по времени. Ротация происходит внутри
+// write() под тем же замком обработчика, что и сама запись: буфер сбрасывается в старый файл,
+// файл переименовывается и открывается заново, поэтому записи не теряются и не повторяются
+class RotatingFileWriter
+{
+    private:
+
+        BufferedFileWriter writer_;
+        RotationOptions rotation_;
+        std::unique_ptr<SegmentCompressor> compressor_;
+        std::chrono::system_clock::time_point next_rotation_ = std::chrono::system_clock::time_point::max();
+        std::uint32_t rotation_count_ = 0;
+
+        // Границы считаются по местному времени, как и имена сегментов. Интервалы, на которые
+        // делятся сутки, отсчитываются от местной полуночи через mktime — переход на летнее
+        // время не сдвигает их. Остальные — от эпохи со сдвигом текущего часового пояса
+        void schedule_next_rotation()
+        {
+            if (rotation_.interval.count() <= 0) return;
+
+            const std::int64_t day = 24 * 60 * 60;
+            std::int64_t step = rotation_.interval.count();
+            std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            std::tm local{};
+            localtime_r(&now, &local);
+
+            std::time_t next;
+            if (day % step == 0)
+            {
+                std::int64_t of_day = local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+                std::tm boundary = local;
+                boundary.tm_hour = 0;
+                boundary.tm_min = 0;
+                boundary.tm_sec = static_cast<int>((of_day / step + 1) * step); // mktime перенесёт в следующие сутки
+                boundary.tm_isdst = -1;
+                next = std::mktime(&boundary);
+                if (next <= now) next = now + static_cast<std::time_t>(step); // повтор часа при переводе часов назад
+            }
+            else
+            {
+                std::int64_t local_seconds = static_cast<std::int64_t>(now) + local.tm_gmtoff;
+                next = static_cast<std::time_t>((local_seconds / step + 1) * step - local.tm_gmtoff);
+            }
+            next_rotation_ = std::chrono::system_clock::from_time_t(next);
+        }
+
+        std::string segment_path()
+        {
+            std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            std::tm local{};
+            localtime_r(&now, &local);
+            char stamp[32];
+            std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &local);
+
+            // Номер различает сегменты одной секунды; занятые имена (например, от прошлого запуска) пропускаем
+            std::string path;
+            std::error_code error;
+            do
+            {
+                char suffix[16];
+                std::snprintf(suffix, sizeof(suffix), "-%04u", static_cast<unsigned>(rotation_count_++ % 10000));
+                path = writer_.path() + "." + stamp + suffix;
+            }
+            while (std::filesystem::exists(path, error) || std::filesystem::exists(path + ".gz", error));
+            return path;
+        }
+
+        void rotate_if_needed()
+        {
+            bool by_size = rotation_.max_bytes > 0 && writer_.size() >= rotation_.max_bytes;
+            bool by_time = rotation_.interval.count() > 0 && std::chrono::system_clock::now() >= next_rotation_;
+            if (by_size || by_time) rotate();
+        }
+
+    public:
+
+        RotatingFileWriter(const std::string& file_path, RotationOptions rotation, FileBufferOptions options = {})
+            : writer_(file_path, options)
+            , rotation_(rotation)
+        {
+            if (rotation_.enabled())
+            {
+                compressor_ = std::make_unique<SegmentCompressor>(file_path, rotation_);
+                schedule_next_rotation();
+            }
+        }
+
+        void write(LogLevel level, std::string_view prefix, std::string_view text)
+        {
+            if (compressor_) rotate_if_needed();
+            writer_.write(level, prefix, text);
+        }
+
+        // Закрыть текущий сегмент и начать новый; сжатие и чистка — в фоне
+        void rotate()
+        {
+            writer_.flush();
+            if (writer_.size() > 0)
+            {
+                std::string segment = segment_path();
+                std::error_code error;
+                std::filesystem::rename(writer_.path(), segment, error);
+                if (!error && compressor_) compressor_->submit(std::move(segment));
+            }
+            writer_.reopen();
+            schedule_next_rotation();
+        }
+
+        void flush() { writer_.flush(); }
+        void reopen() { writer_.reopen(); }
+        const std::string& path() const { return writer_.path(); }
+        bool io_stats(HandlerIoStats& stats) const { return writer_.io_stats(stats); }
+};
\ No newline at end of file
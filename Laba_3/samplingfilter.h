@@ -0,0 +1,146 @@
+#pragma once
+
+#include "ilogfilter.h"
+#include "loghash.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// По чему решается, попадает ли запись в выборку
+enum class SampleBy
+{
+    Message,  // по хешу текста: одно и то же сообщение всегда либо проходит, либо нет
+    Thread    // по потоку: поток целиком либо в выборке, либо нет; текст не нужен
+};
+
+struct SamplingOptions
+{
+    double rate = 0.1;                          // доля записей, которая проходит
+    SampleBy by = SampleBy::Message;
+    LevelMask always = levels_from(LogLevel::WARN); // эти уровни проходят всегда
+    std::uint64_t seed = 0;                     // разные seed — независимые выборки
+
+    // Адаптивный режим: если записей (до выборки) больше target_per_second,
+    // доля снижается до target / поток, но не ниже min_rate. 0 — доля постоянная
+    double target_per_second = 0.0;
+    double min_rate = 0.001;
+    std::chrono::milliseconds window{1000};     // как часто пересчитывается доля
+};
+
+// Детерминированная выборка по хешу: запись проходит, если хеш ключа меньше rate * 2^64.
+// Без замков: доля хранится как порог в атомарной переменной, поток записей считается
+// пачками по kCountBatch в счётчике потока и раз в пачку добавляется к общему
+class SamplingFilter : public ILogFilter
+{
+    private:
+
+        static constexpr std::uint32_t kCountBatch = 64;
+        static constexpr std::size_t kBatchSlots = 8;   // пачек на поток: столько фильтров не мешают друг другу
+
+        static std::uint64_t next_id()
+        {
+            static std::atomic<std::uint64_t> counter{0};
+            return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        // Номер, а не адрес: новый фильтр на месте удалённого не подхватит чужую пачку
+        const std::uint64_t id_ = next_id();
+
+        SamplingOptions options_;
+        mutable std::atomic<std::uint64_t> threshold_;
+
+        // Адаптивный режим: записи текущего окна и начало окна
+        alignas(64) mutable std::atomic<std::uint64_t> window_count_{0};
+        mutable std::atomic<std::int64_t> window_start_ns_;
+
+        static std::uint64_t to_threshold(double rate)
+        {
+            if (rate >= 1.0) return UINT64_MAX;
+            if (rate <= 0.0) return 0;
+            return static_cast<std::uint64_t>(rate * 18446744073709551616.0); // 2^64
+        }
+
+        static std::int64_t now_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        std::uint64_t thread_key() const
+        {
+            thread_local std::uint64_t id = loghash::mix(std::hash<std::thread::id>{}(std::this_thread::get_id()) + 1);
+            return loghash::mix(id ^ options_.seed);
+        }
+
+        // Раз в окно: доля = target / фактический поток, в пределах [min_rate, rate]
+        void count_record() const
+        {
+            // У каждого фильтра своя пачка в потоке: поток, который пишет через несколько
+            // фильтров по очереди, не обнуляет их счёт. Ячейку делят фильтры, чьи номера
+            // совпадают по модулю kBatchSlots; вытесненная пачка (меньше kCountBatch записей) теряется
+            struct Batch
+            {
+                std::uint64_t owner = 0;
+                std::uint32_t count = 0;
+            };
+            thread_local Batch batches[kBatchSlots];
+            Batch& batch = batches[id_ % kBatchSlots];
+            if (batch.owner != id_)
+            {
+                batch.owner = id_;
+                batch.count = 0;
+            }
+            if (++batch.count < kCountBatch) return;
+            batch.count = 0;
+
+            std::uint64_t seen = window_count_.fetch_add(kCountBatch, std::memory_order_relaxed) + kCountBatch;
+            std::int64_t start = window_start_ns_.load(std::memory_order_relaxed);
+            std::int64_t now = now_ns();
+            std::int64_t window = std::chrono::duration_cast<std::chrono::nanoseconds>(options_.window).count();
+            if (now - start < window) return;
+
+            // Пересчитывает тот, кто первым закрыл окно
+            if (!window_start_ns_.compare_exchange_strong(start, now, std::memory_order_relaxed)) return;
+            window_count_.fetch_sub(seen, std::memory_order_relaxed);
+
+            double per_second = static_cast<double>(seen) * 1e9 / static_cast<double>(now - start);
+            double rate = options_.rate;
+            if (per_second > options_.target_per_second)
+            {
+                rate = std::max(options_.min_rate, std::min(rate, options_.target_per_second / per_second));
+            }
+            threshold_.store(to_threshold(rate), std::memory_order_relaxed);
+        }
+
+    public:
+
+        explicit SamplingFilter(SamplingOptions options = {})
+            : options_(options)
+            , threshold_(to_threshold(options.rate))
+            , window_start_ns_(now_ns())
+        {}
+
+        bool match(LogLevel level, const std::string& text) const override
+        {
+            if (options_.always & level_bit(level)) return true;
+            if (options_.target_per_second > 0.0) count_record();
+
+            std::uint64_t key = options_.by == SampleBy::Thread ? thread_key() : loghash::hash(text, options_.seed);
+            return key < threshold_.load(std::memory_order_relaxed);
+        }
+
+        bool uses_text() const override { return options_.by == SampleBy::Message; }
+
+        // Адаптивная доля зависит от числа дошедших записей
+        bool reorderable() const override { return options_.target_per_second <= 0.0; }
+
+        // Текущая доля; в адаптивном режиме меняется раз в окно
+        double current_rate() const
+        {
+            return static_cast<double>(threshold_.load(std::memory_order_relaxed)) / 18446744073709551616.0;
+        }
+};
\ No newline at end of file
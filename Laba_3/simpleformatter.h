@@ -1,34 +1,67 @@
 #pragma once
 
 #include "ilogformatter.h"
+#include "logclock.h"
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <ctime>
 #include <string>
   
-class SimpleFormatter : public ILogFormatter 
+class SimpleFormatter : public IAffixFormatter 
 {
-    public:
+    private:
+
+        LogClock clock_;
+
+        // Дата и время с точностью до секунды меняются редко — держим готовую строку
+        // и пересобираем её только при смене секунды. Своя копия у каждого потока
+        struct TimeCache
+        {
+            std::time_t second = -1;
+            char text[32] = {};
+            std::size_t length = 0;
+        };
 
-        std::string format(LogLevel level, const std:: string& text) const override 
+        static const TimeCache& cached_time(std::time_t second)
         {
-            std::string level_str;
-            switch (level) 
+            thread_local TimeCache cache;
+            if (cache.second != second)
             {
-                case LogLevel::INFO:  level_str = "INFO";  break;
-                case LogLevel::WARN:  level_str = "WARN";  break;
-                case LogLevel::ERROR: level_str = "ERROR"; break;
+                std::tm local{};
+                localtime_r(&second, &local); // в отличие от std::localtime, потокобезопасна
+                cache.length = std::strftime(cache.text, sizeof(cache.text), "%Y.%m.%d %H:%M:%S", &local);
+                cache.second = second;
             }
+            return cache;
+        }
+
+    public:
+
+        // Точность и цена времени выбираются здесь: SimpleFormatter({ClockMode::Coarse})
+        explicit SimpleFormatter(ClockOptions clock = {}) : clock_(clock) {}
+
+        // "[LEVEL] [YYYY.MM.DD HH:MM:SS.mmm] " без промежуточных строк:
+        // когда буфер out прогрелся, выделений памяти нет
+        void append_prefix(LogLevel level, std::string& out) const override
+        {
+            append_prefix_at(level, clock_.now_ns(), out);
+        }
 
-            auto now = std::chrono::system_clock::now();
-            auto time_t = std::chrono::system_clock::to_time_t(now);
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+        void append_prefix_at(LogLevel level, std::int64_t timestamp_ns, std::string& out) const override
+        {
+            std::int64_t since_epoch_ms = timestamp_ns / 1000000;
+            auto seconds = static_cast<std::time_t>(since_epoch_ms / 1000);
+            auto ms = static_cast<int>(since_epoch_ms % 1000);
 
-            std::ostringstream oss;
-            oss << std::put_time(std::localtime(&time_t), "%Y.%m.%d %H:%M:%S");
+            const TimeCache& time = cached_time(seconds);
 
-            std::string time_str = oss.str();
+            char millis[4] = {
+                static_cast<char>('0' + ms / 100),
+                static_cast<char>('0' + ms / 10 % 10),
+                static_cast<char>('0' + ms % 10),
+                '\0'
+            };
 
-            return "[" + level_str + "] [" + time_str + "] " + text;
+            out.append("[").append(to_string(level)).append("] [");
+            out.append(time.text, time.length).append(".").append(millis, 3).append("] ");
         }
 };
\ No newline at end of file
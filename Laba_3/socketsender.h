@@ -0,0 +1,512 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class SocketProtocol
+{
+    Tcp,
+    Udp
+};
+
+struct SocketOptions
+{
+    SocketProtocol protocol = SocketProtocol::Tcp;
+    std::size_t max_pending_bytes = 4 * 1024 * 1024;          // очередь в памяти; сверх неё записи теряются
+    std::string spill_path;                                    // пусто — "socket_<host>_<port>.spill"
+    std::uint64_t max_spill_bytes = 64 * 1024 * 1024;         // очередь на диске, пока сборщик недоступен
+    std::chrono::milliseconds min_backoff{100};                // пауза перед первой повторной попыткой
+    std::chrono::milliseconds max_backoff{10000};              // пауза растёт вдвое до этого предела
+    std::size_t max_datagram = 1400;                           // UDP: записи пакуются в датаграммы до этого размера
+};
+
+// Отправка строк лога сборщику по TCP или UDP из отдельного потока на epoll.
+// push() только дописывает строку в буфер в памяти; сокет, переподключение с растущей паузой
+// и очередь на диске (spill), куда уходят записи, пока сборщик недоступен, — забота фонового потока.
+// Порядок записей сохраняется: при восстановлении связи сначала отправляется spill, потом память
+class SocketSender
+{
+    private:
+
+        // Сколько деструктор ждёт отправки остатка живому, но медленному сборщику
+        static constexpr std::chrono::milliseconds kStopTimeout{1000};
+
+        std::string host_;
+        int port_;
+        SocketOptions options_;
+
+        // Общее с push(): строки, ещё не взятые фоновым потоком
+        std::mutex mutex_;
+        std::string pending_;
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<bool> stop_{false};
+
+        // Дальше — только фоновый поток
+        int epoll_fd_ = -1;
+        int wake_fd_ = -1;
+        int socket_fd_ = -1;
+        bool connecting_ = false;
+        bool connected_ = false;
+        addrinfo* addresses_ = nullptr;     // адреса сборщика для текущей серии попыток
+        addrinfo* next_address_ = nullptr;  // следующий ещё не испробованный из них
+        std::chrono::milliseconds backoff_{0};
+        std::chrono::steady_clock::time_point next_attempt_;
+
+        std::string outgoing_;          // то, что отправляется сейчас
+        std::size_t sent_ = 0;          // сколько байт outgoing_ уже ушло
+        bool from_spill_ = false;       // outgoing_ прочитан из spill, а не из памяти
+        std::uint64_t spill_size_ = 0;  // размер файла spill
+        std::uint64_t spill_read_ = 0;  // сколько байт spill уже отправлено
+
+        std::thread worker_;
+
+        void wake()
+        {
+            std::uint64_t one = 1;
+            ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+            (void)ignored;
+        }
+
+        void watch_socket(std::uint32_t events)
+        {
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = socket_fd_;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket_fd_, &event);
+        }
+
+        void close_socket()
+        {
+            if (socket_fd_ >= 0)
+            {
+                epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket_fd_, nullptr);
+                ::close(socket_fd_);
+            }
+            socket_fd_ = -1;
+            connecting_ = false;
+            connected_ = false;
+        }
+
+        void schedule_reconnect()
+        {
+            close_socket();
+            backoff_ = backoff_.count() == 0 ? options_.min_backoff : std::min(backoff_ * 2, options_.max_backoff);
+            next_attempt_ = std::chrono::steady_clock::now() + backoff_;
+        }
+
+        void free_addresses()
+        {
+            if (addresses_) freeaddrinfo(addresses_);
+            addresses_ = nullptr;
+            next_address_ = nullptr;
+        }
+
+        // Пробует адреса сборщика по очереди: "localhost" может дать сначала ::1, а сборщик
+        // слушает только 127.0.0.1. Пауза перед новой попыткой — только когда не подошёл ни один
+        void start_connect()
+        {
+            if (!next_address_)
+            {
+                free_addresses();
+                addrinfo hints{};
+                hints.ai_family = AF_UNSPEC;
+                hints.ai_socktype = options_.protocol == SocketProtocol::Tcp ? SOCK_STREAM : SOCK_DGRAM;
+                std::string port = std::to_string(port_);
+                if (getaddrinfo(host_.c_str(), port.c_str(), &hints, &addresses_) != 0 || !addresses_)
+                {
+                    addresses_ = nullptr;
+                    schedule_reconnect();
+                    return;
+                }
+                next_address_ = addresses_;
+            }
+
+            int result = -1;
+            while (next_address_)
+            {
+                addrinfo* address = next_address_;
+                next_address_ = address->ai_next;
+
+                socket_fd_ = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+                result = socket_fd_ >= 0 ? ::connect(socket_fd_, address->ai_addr, address->ai_addrlen) : -1;
+                if (socket_fd_ >= 0 && (result == 0 || errno == EINPROGRESS)) break;
+
+                if (socket_fd_ >= 0) ::close(socket_fd_);
+                socket_fd_ = -1;
+            }
+
+            if (socket_fd_ < 0)
+            {
+                schedule_reconnect();
+                return;
+            }
+
+            if (options_.protocol == SocketProtocol::Tcp)
+            {
+                int on = 1;
+                setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+
+            epoll_event event{};
+            event.events = EPOLLOUT | EPOLLIN;
+            event.data.fd = socket_fd_;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_fd_, &event);
+            connecting_ = result != 0;
+            connected_ = result == 0;
+            if (connected_)
+            {
+                backoff_ = std::chrono::milliseconds(0);
+                free_addresses();
+            }
+        }
+
+        void finish_connect()
+        {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(socket_fd_, SOL_SOCKET, SO_ERROR, &error, &length);
+            connecting_ = false;
+            if (error != 0)
+            {
+                // Этот адрес не ответил — сразу пробуем следующий, если он есть
+                if (next_address_)
+                {
+                    close_socket();
+                    start_connect();
+                }
+                else
+                {
+                    schedule_reconnect();
+                }
+                return;
+            }
+            connected_ = true;
+            backoff_ = std::chrono::milliseconds(0);
+            free_addresses();
+        }
+
+        // Связь пропала: неотправленное уходит в spill. Строку, которая ушла не целиком,
+        // отправим заново с начала, чтобы сборщик не получил обрывок
+        void on_disconnect()
+        {
+            if (sent_ < outgoing_.size())
+            {
+                std::size_t line_start = outgoing_.rfind('\n', sent_ == 0 ? 0 : sent_ - 1);
+                line_start = (line_start == std::string::npos || sent_ == 0) ? 0 : line_start + 1;
+                if (from_spill_)
+                {
+                    // Файл и так хранит эти байты — достаточно отмотать позицию чтения
+                    spill_read_ -= outgoing_.size() - line_start;
+                }
+                else
+                {
+                    spill(std::string_view(outgoing_).substr(line_start));
+                }
+            }
+            outgoing_.clear();
+            sent_ = 0;
+            schedule_reconnect();
+        }
+
+        void spill(std::string_view data)
+        {
+            if (data.empty()) return;
+            if (spill_size_ + data.size() > options_.max_spill_bytes)
+            {
+                dropped_.fetch_add(static_cast<std::uint64_t>(std::count(data.begin(), data.end(), '\n')), std::memory_order_relaxed);
+                return;
+            }
+
+            int fd = ::open(options_.spill_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0) return;
+            while (!data.empty())
+            {
+                ssize_t written = ::write(fd, data.data(), data.size());
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                data.remove_prefix(static_cast<std::size_t>(written));
+                spill_size_ += static_cast<std::uint64_t>(written);
+            }
+            ::close(fd);
+        }
+
+        // Выбрасывает из начала spill уже отправленное, чтобы следующий запуск не повторил его
+        void compact_spill()
+        {
+            if (spill_read_ == 0) return;
+
+            std::string rest;
+            int fd = ::open(options_.spill_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0 && spill_read_ < spill_size_)
+            {
+                rest.resize(static_cast<std::size_t>(spill_size_ - spill_read_));
+                ssize_t read = ::pread(fd, rest.data(), rest.size(), static_cast<off_t>(spill_read_));
+                rest.resize(read > 0 ? static_cast<std::size_t>(read) : 0);
+            }
+            if (fd >= 0) ::close(fd);
+
+            fd = ::open(options_.spill_path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+            if (fd >= 0) ::close(fd);
+            spill_size_ = 0;
+            spill_read_ = 0;
+            spill(rest);
+        }
+
+        // Следующая порция для отправки: сначала из spill, потом из памяти
+        bool refill()
+        {
+            outgoing_.clear();
+            sent_ = 0;
+            from_spill_ = false;
+
+            if (spill_read_ < spill_size_)
+            {
+                int fd = ::open(options_.spill_path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd >= 0)
+                {
+                    std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(spill_size_ - spill_read_, 256 * 1024));
+                    outgoing_.resize(chunk);
+                    ssize_t read = ::pread(fd, outgoing_.data(), chunk, static_cast<off_t>(spill_read_));
+                    ::close(fd);
+                    outgoing_.resize(read > 0 ? static_cast<std::size_t>(read) : 0);
+                    spill_read_ += outgoing_.size();
+                }
+                if (outgoing_.empty()) spill_read_ = spill_size_; // файл пропал или испорчен
+                from_spill_ = !outgoing_.empty();
+                if (from_spill_) return true;
+            }
+
+            if (spill_size_ > 0 && spill_read_ >= spill_size_)
+            {
+                int fd = ::open(options_.spill_path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+                if (fd >= 0) ::close(fd);
+                spill_size_ = 0;
+                spill_read_ = 0;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            outgoing_.swap(pending_);
+            return !outgoing_.empty();
+        }
+
+        // UDP: датаграмма — несколько целых строк, не длиннее max_datagram (длинная строка — одна)
+        std::size_t next_datagram_size() const
+        {
+            std::size_t limit = std::min(outgoing_.size() - sent_, options_.max_datagram);
+            if (sent_ + limit == outgoing_.size()) return limit;
+            std::size_t end = outgoing_.rfind('\n', sent_ + limit - 1);
+            if (end != std::string::npos && end >= sent_) return end + 1 - sent_;
+            end = outgoing_.find('\n', sent_);
+            std::size_t size = (end == std::string::npos ? outgoing_.size() : end + 1) - sent_;
+            return std::min<std::size_t>(size, 65507);
+        }
+
+        // Отправляет, пока сокет принимает; false — связь оборвалась
+        bool send_some()
+        {
+            for (;;)
+            {
+                if (sent_ >= outgoing_.size() && !refill()) return true;
+
+                std::size_t size = options_.protocol == SocketProtocol::Udp ? next_datagram_size() : outgoing_.size() - sent_;
+                ssize_t sent = ::send(socket_fd_, outgoing_.data() + sent_, size, MSG_NOSIGNAL);
+                if (sent < 0)
+                {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    {
+                        watch_socket(EPOLLOUT | EPOLLIN);
+                        return true;
+                    }
+                    return false;
+                }
+                sent_ += static_cast<std::size_t>(sent);
+            }
+        }
+
+        bool has_data()
+        {
+            if (sent_ < outgoing_.size() || spill_read_ < spill_size_) return true;
+            std::lock_guard<std::mutex> lock(mutex_);
+            return !pending_.empty();
+        }
+
+        // Пока связи нет, всё из памяти уходит в spill, чтобы память не росла
+        void spill_pending()
+        {
+            std::string batch;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                batch.swap(pending_);
+            }
+            spill(batch);
+        }
+
+        void run()
+        {
+            epoll_event events[4];
+            next_attempt_ = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::time_point stop_deadline{};
+
+            for (;;)
+            {
+                bool stopping = stop_.load(std::memory_order_acquire);
+                auto now = std::chrono::steady_clock::now();
+                if (stopping && stop_deadline == std::chrono::steady_clock::time_point{})
+                {
+                    stop_deadline = now + kStopTimeout;
+                }
+
+                if (socket_fd_ < 0 && now >= next_attempt_) start_connect();
+
+                if (connected_)
+                {
+                    if (!send_some()) on_disconnect();
+                    else if (sent_ >= outgoing_.size() && !has_data()) watch_socket(EPOLLIN);
+                }
+                else if (!connecting_)
+                {
+                    spill_pending();
+                }
+
+                if (stopping && (!connected_ || !has_data() || now >= stop_deadline)) break;
+
+                int timeout = -1;
+                if (socket_fd_ < 0)
+                {
+                    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_attempt_ - std::chrono::steady_clock::now());
+                    timeout = static_cast<int>(std::max<std::int64_t>(0, wait.count()));
+                }
+                if (stopping) timeout = 50;
+
+                int count = epoll_wait(epoll_fd_, events, 4, timeout);
+                for (int i = 0; i < count; ++i)
+                {
+                    if (events[i].data.fd == wake_fd_)
+                    {
+                        std::uint64_t value = 0;
+                        ssize_t ignored = ::read(wake_fd_, &value, sizeof(value));
+                        (void)ignored;
+                        continue;
+                    }
+                    if (events[i].data.fd != socket_fd_) continue;
+
+                    if (connecting_)
+                    {
+                        finish_connect();
+                    }
+                    else if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP | EPOLLIN))
+                    {
+                        // Сборщик ничего не шлёт в ответ: данные на чтение — это закрытие или ошибка
+                        char scratch[512];
+                        ssize_t read = ::recv(socket_fd_, scratch, sizeof(scratch), MSG_DONTWAIT);
+                        bool closed = read == 0 || (read < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+                        if (closed || (events[i].events & (EPOLLERR | EPOLLHUP))) on_disconnect();
+                    }
+                }
+            }
+
+            // Всё неотправленное сохраняется на диске до следующего запуска
+            if (sent_ < outgoing_.size())
+            {
+                on_disconnect();
+            }
+            compact_spill();
+            spill_pending();
+            close_socket();
+            free_addresses();
+        }
+
+    public:
+
+        SocketSender(const std::string& host, int port, SocketOptions options = {})
+            : host_(host)
+            , port_(port)
+            , options_(std::move(options))
+        {
+            if (options_.spill_path.empty())
+            {
+                options_.spill_path = "socket_" + host + "_" + std::to_string(port) + ".spill";
+            }
+
+            // То, что не успели отправить в прошлый раз, отправится первым
+            struct stat info{};
+            if (::stat(options_.spill_path.c_str(), &info) == 0)
+            {
+                spill_size_ = static_cast<std::uint64_t>(info.st_size);
+            }
+
+            epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+            wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = wake_fd_;
+            epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+            worker_ = std::thread([this] { run(); });
+        }
+
+        SocketSender(const SocketSender&) = delete;
+        SocketSender& operator=(const SocketSender&) = delete;
+
+        // Дожидается отправки, если связь есть, иначе сохраняет остаток в spill
+        ~SocketSender()
+        {
+            stop_.store(true, std::memory_order_release);
+            wake();
+            worker_.join();
+            ::close(wake_fd_);
+            ::close(epoll_fd_);
+        }
+
+        // Добавляет строку в очередь. Фоновый поток будится, только когда очередь была пуста,
+        // так что под нагрузкой системный вызов приходится на пачку, а не на запись
+        void push(std::string_view prefix, std::string_view text)
+        {
+            bool was_empty = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (pending_.size() + prefix.size() + text.size() + 1 > options_.max_pending_bytes)
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                was_empty = pending_.empty();
+                pending_.append(prefix);
+                pending_.append(text);
+                pending_.push_back('\n');
+            }
+            if (was_empty) wake();
+        }
+
+        void flush() { wake(); }
+
+        std::uint64_t dropped_count() const { return dropped_.load(std::memory_order_relaxed); }
+
+        std::size_t pending_bytes()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return pending_.size();
+        }
+};
\ No newline at end of file